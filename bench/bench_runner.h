@@ -0,0 +1,156 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+//
+// Minimal microbenchmark runner (no external dependency)
+//
+// A sample times a batch of calls, the batch size is calibrated so that a
+// sample lasts at least min_sample_ns. Per call statistics are computed over
+// the samples taken after warmup.
+//
+
+namespace bench {
+// keep a value alive (the computation producing it cannot be removed)
+template <typename T> inline void do_not_optimize(T const &value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  auto const *p = reinterpret_cast<char const volatile *>(&value);
+  static_cast<void>(*p);
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// make a value opaque (the compiler cannot constant fold or hoist its uses)
+template <typename T> inline void clobber(T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : "+m"(value) : : "memory");
+#else
+  auto *p = reinterpret_cast<char volatile *>(&value);
+  *p = *p;
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+struct options {
+  std::size_t warmup{10};
+  std::size_t repetitions{101};
+  std::uint64_t min_sample_ns{200000};
+};
+
+struct result {
+  std::string name;
+  std::size_t batch{};
+  std::size_t repetitions{};
+  std::size_t bytes_per_call{};
+  double median_ns{};
+  double p99_ns{};
+  double min_ns{};
+  double mean_ns{};
+};
+
+namespace detail {
+using clock = std::chrono::steady_clock;
+
+template <typename F> double sample_ns(F &f, std::size_t batch) {
+  auto const start = clock::now();
+  for (std::size_t i = 0; i < batch; ++i) {
+    f();
+  }
+  auto const stop = clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count();
+}
+
+// nearest rank on sorted samples
+inline double quantile(std::vector<double> const &sorted, double q) {
+  auto const rank = static_cast<std::size_t>(q * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(rank, sorted.size() - 1)];
+}
+} // namespace detail
+
+template <typename F>
+result run(std::string name, F &&f, options const &opts = {},
+           std::size_t bytes_per_call = 0) {
+  std::size_t batch = 1;
+  while (batch < (std::size_t{1} << 30) &&
+         detail::sample_ns(f, batch) < opts.min_sample_ns) {
+    batch *= 2;
+  }
+
+  for (std::size_t i = 0; i < opts.warmup; ++i) {
+    detail::sample_ns(f, batch);
+  }
+
+  std::vector<double> samples;
+  samples.reserve(opts.repetitions);
+  for (std::size_t i = 0; i < std::max<std::size_t>(opts.repetitions, 1);
+       ++i) {
+    samples.push_back(detail::sample_ns(f, batch) / batch);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  result res{std::move(name), batch, samples.size(), bytes_per_call};
+  res.median_ns = detail::quantile(samples, 0.5);
+  res.p99_ns = detail::quantile(samples, 0.99);
+  res.min_ns = samples.front();
+  for (auto const s : samples) {
+    res.mean_ns += s / samples.size();
+  }
+  return res;
+}
+
+// results as a json document (one object per benchmark)
+inline void write_json(std::ostream &os, std::vector<result> const &results,
+                       options const &opts) {
+  os << "{\n  \"suite\": \"pipet_bench\",\n";
+#if defined(__clang__)
+  os << "  \"compiler\": \"clang " << __clang_version__ << "\",\n";
+#elif defined(__GNUC__)
+  os << "  \"compiler\": \"gcc " << __VERSION__ << "\",\n";
+#elif defined(_MSC_VER)
+  os << "  \"compiler\": \"msvc " << _MSC_FULL_VER << "\",\n";
+#endif
+  os << "  \"warmup\": " << opts.warmup << ",\n"
+     << "  \"min_sample_ns\": " << opts.min_sample_ns << ",\n"
+     << "  \"results\": [";
+
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    auto const &r = results[i];
+    os << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name
+       << "\", \"batch\": " << r.batch
+       << ", \"repetitions\": " << r.repetitions
+       << ", \"median_ns\": " << r.median_ns << ", \"p99_ns\": " << r.p99_ns
+       << ", \"min_ns\": " << r.min_ns << ", \"mean_ns\": " << r.mean_ns;
+    if (r.bytes_per_call) {
+      os << ", \"bytes_per_call\": " << r.bytes_per_call
+         << ", \"median_mb_per_s\": " << r.bytes_per_call * 1e3 / r.median_ns;
+    }
+    os << "}";
+  }
+
+  os << "\n  ]\n}" << std::endl;
+}
+} // namespace bench
\ No newline at end of file
@@ -0,0 +1,98 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "pipet/pipet.h"
+
+//
+// Latency of serial vs parallel evaluation of heavy independent branches
+//
+
+namespace {
+// cpu bound filter (xorshift rounds)
+template <std::size_t Rounds> struct heavy_filter {
+  static uint64_t process(uint64_t x) {
+    for (std::size_t i = 0; i < Rounds; ++i) {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+    }
+    return x;
+  }
+};
+
+struct sum4_filter {
+  static uint64_t process(uint64_t a, uint64_t b, uint64_t c, uint64_t d) {
+    return a + b + c + d;
+  }
+};
+
+struct id_filter {
+  static uint64_t process(uint64_t x) { return x; }
+};
+
+template <typename Pipe> double median_latency_us(std::size_t reps) {
+  std::vector<double> samples;
+  samples.reserve(reps);
+  volatile uint64_t sink = 0;
+
+  for (std::size_t i = 0; i < reps; ++i) {
+    auto const start = std::chrono::steady_clock::now();
+    sink = sink + Pipe::process(i + 1);
+    auto const stop = std::chrono::steady_clock::now();
+    samples.push_back(
+        std::chrono::duration<double, std::micro>(stop - start).count());
+  }
+
+  std::nth_element(samples.begin(), samples.begin() + reps / 2, samples.end());
+  return samples[reps / 2];
+}
+
+template <std::size_t Rounds> void run(std::size_t reps) {
+  using branch_t = pipet::pipe<id_filter, heavy_filter<Rounds>>;
+  using serial_t = pipet::pipe<
+      id_filter, pipet::branches<branch_t, branch_t, branch_t, branch_t>,
+      sum4_filter>;
+  using parallel_t = pipet::pipe<
+      id_filter, pipet::par_branches<branch_t, branch_t, branch_t, branch_t>,
+      sum4_filter>;
+
+  // warm up the shared pool
+  median_latency_us<parallel_t>(10);
+
+  auto const serial = median_latency_us<serial_t>(reps);
+  auto const parallel = median_latency_us<parallel_t>(reps);
+
+  std::cout << "rounds=" << Rounds << " serial_us=" << serial
+            << " parallel_us=" << parallel
+            << " speedup=" << serial / parallel << std::endl;
+}
+} // namespace
+
+int main() {
+  std::cout << "[--- branches latency (4 branches, "
+            << pipet::helpers::thread_pool::shared().size()
+            << " workers) ---]" << std::endl;
+
+  run<1000>(2000);
+  run<10000>(500);
+  run<100000>(100);
+
+  return 0;
+}
@@ -0,0 +1,182 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+//
+// Build time and peak compiler memory of generated pipes of 10 to 1000 stages
+// and of typelist algorithms on lists of 100 to 1000 types (point the include
+// dir to another pipet checkout for a before/after comparison)
+//
+// usage: pipet_compile_bench <compiler> <pipet include dir> <work dir> [csv]
+//
+
+namespace {
+constexpr int stage_counts[] = {10, 100, 500, 1000};
+constexpr int type_counts[] = {100, 500, 1000};
+
+struct result {
+  bool ok;
+  double seconds;
+  long peak_kb;
+};
+
+void generate_pipe(std::string const &path, int stages) {
+  std::ofstream os{path};
+  os << "#include \"pipet/pipet.h\"\n\n"
+     << "template <int I> struct stage {\n"
+     << "  static constexpr unsigned process(unsigned a) { return a * 3u + I; }\n"
+     << "  static constexpr unsigned reverse(unsigned a) { return (a - I) / 3u; }\n"
+     << "};\n\n"
+     << "using pipe_t = pipet::pipe<";
+
+  for (int i = 0; i < stages; ++i) {
+    os << (i ? ",\n    " : "\n    ") << "stage<" << i << ">";
+  }
+
+  os << ">;\n\n"
+     << "unsigned run(unsigned v) {\n"
+     << "  return pipe_t::process(v) ^ pipe_t::reverse(v);\n"
+     << "}\n";
+}
+
+void generate_typelist(std::string const &path, int types) {
+  std::ofstream os{path};
+  os << "#include \"pipet/helpers/typelist.h\"\n\n"
+     << "using namespace pipet::helpers;\n\n"
+     << "template <int I> struct item {};\n\n"
+     << "using list_t = typelist<";
+
+  for (int i = 0; i < types; ++i) {
+    os << (i ? ",\n    " : "\n    ") << "item<" << i << ">";
+  }
+
+  // half of the types twice
+  os << ">;\n\n"
+     << "using dup_t = typelist<";
+
+  for (int i = 0; i < types; ++i) {
+    os << (i ? ",\n    " : "\n    ") << "item<" << i / 2 << ">";
+  }
+
+  os << ">;\n\n"
+     << "static_assert(size_v<remove_dup_t<dup_t>> == " << types / 2 << ");\n"
+     << "static_assert(size_v<merge_all_t<dup_t, typelist<item<"
+     << types / 2 << ">>>> == " << types / 2 + 1 << ");\n"
+     << "static_assert(has_v<item<" << types - 1 << ">, list_t>);\n"
+     << "static_assert(size_v<pop_back_t<list_t>> == " << types - 1 << ");\n"
+     << "static_assert(size_v<push_back_t<int, list_t>> == " << types + 1
+     << ");\n";
+}
+
+result compile(std::string const &compiler, std::string const &include_dir,
+               std::string const &src, std::string const &obj) {
+  std::vector<std::string> args{
+      compiler, "-std=c++17", "-O2", "-I" + include_dir, "-c", src, "-o", obj};
+
+  auto const start = std::chrono::steady_clock::now();
+  auto const pid = fork();
+  if (pid < 0) {
+    return {false, 0., 0};
+  }
+
+  if (pid == 0) {
+    std::vector<char *> argv;
+    for (auto &a : args) {
+      argv.push_back(a.data());
+    }
+    argv.push_back(nullptr);
+
+    auto const null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+    dup2(null_fd, STDERR_FILENO);
+    execvp(argv[0], argv.data());
+    _exit(127);
+  }
+
+  // peak rss of the compiler driver and of its waited-for children (cc1plus)
+  int status = 0;
+  rusage usage{};
+  wait4(pid, &status, 0, &usage);
+  auto const stop = std::chrono::steady_clock::now();
+
+  return {WIFEXITED(status) && WEXITSTATUS(status) == 0,
+          std::chrono::duration<double>(stop - start).count(),
+          usage.ru_maxrss};
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 4) {
+    std::cerr << "usage: " << argv[0]
+              << " <compiler> <pipet include dir> <work dir> [csv]\n";
+    return 1;
+  }
+
+  std::string const compiler{argv[1]};
+  std::string const include_dir{argv[2]};
+  std::string const work_dir{argv[3]};
+
+  std::ofstream csv;
+  if (argc > 4) {
+    csv.open(argv[4]);
+    csv << "case,size,status,seconds,peak_kb\n";
+  }
+
+  std::cout << std::setw(10) << "case" << std::setw(8) << "size"
+            << std::setw(10) << "status" << std::setw(12) << "time (s)"
+            << std::setw(14) << "peak (MB)" << '\n';
+
+  bool all_ok = true;
+
+  auto const run = [&](std::string const &name, int n, auto generate) {
+    auto const base = work_dir + "/" + name + "_" + std::to_string(n);
+    generate(base + ".cpp", n);
+
+    auto const r = compile(compiler, include_dir, base + ".cpp", base + ".o");
+    all_ok = all_ok && r.ok;
+
+    std::cout << std::setw(10) << name << std::setw(8) << n << std::setw(10)
+              << (r.ok ? "ok" : "failed") << std::setw(12) << std::fixed
+              << std::setprecision(2) << r.seconds << std::setw(14)
+              << std::setprecision(1) << r.peak_kb / 1024. << '\n';
+
+    if (csv) {
+      csv << name << ',' << n << ',' << (r.ok ? "ok" : "failed") << ','
+          << r.seconds << ',' << r.peak_kb << '\n';
+    }
+  };
+
+  for (auto const n : stage_counts) {
+    run("pipe", n, generate_pipe);
+  }
+
+  for (auto const n : type_counts) {
+    run("typelist", n, generate_typelist);
+  }
+
+  // failed builds fail the run (ci builds the long pipes with each compiler)
+  return all_ok ? 0 : 1;
+}
@@ -0,0 +1,754 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "pipet/extra/bit.h"
+#include "pipet/extra/cxstring.h"
+#include "pipet/extra/random.h"
+#include "pipet/extra/sample.h"
+#include "pipet/pipet.h"
+#include "pipet/tabulate.h"
+
+#include "aes.h"
+#include "bench_runner.h"
+#include "obfuscator.h"
+
+//
+// Runtime cost of pipes against hand-written code and of the examples
+//
+// usage: pipet_bench [--filter substr] [--reps n] [json_file]
+//
+
+namespace {
+struct add_filter {
+  static uint64_t process(uint64_t x) { return x + 0x9e3779b97f4a7c15ull; }
+  static uint64_t reverse(uint64_t x) { return x - 0x9e3779b97f4a7c15ull; }
+};
+
+struct xor_filter {
+  static uint64_t process(uint64_t x) { return x ^ (x >> 31); }
+  static uint64_t reverse(uint64_t x) { return x ^ (x >> 31) ^ (x >> 62); }
+};
+
+struct rot_filter {
+  static uint64_t process(uint64_t x) { return (x << 17) | (x >> 47); }
+  static uint64_t reverse(uint64_t x) { return (x >> 17) | (x << 47); }
+};
+
+struct mul_filter {
+  static uint64_t process(uint64_t x) { return x * 0xbf58476d1ce4e5b9ull; }
+  // multiplicative inverse mod 2^64
+  static uint64_t reverse(uint64_t x) { return x * 0x96de1b173f119089ull; }
+};
+
+struct sum4_filter {
+  static uint64_t process(uint64_t a, uint64_t b, uint64_t c, uint64_t d) {
+    return a + b + c + d;
+  }
+};
+
+using chain_t = pipet::pipe<add_filter, xor_filter, rot_filter, mul_filter,
+                            add_filter, xor_filter, rot_filter, mul_filter>;
+
+uint64_t hand_chain(uint64_t x) {
+  x = add_filter::process(x);
+  x = xor_filter::process(x);
+  x = rot_filter::process(x);
+  x = mul_filter::process(x);
+  x = add_filter::process(x);
+  x = xor_filter::process(x);
+  x = rot_filter::process(x);
+  return mul_filter::process(x);
+}
+
+uint64_t hand_chain_reverse(uint64_t x) {
+  x = mul_filter::reverse(x);
+  x = rot_filter::reverse(x);
+  x = xor_filter::reverse(x);
+  x = add_filter::reverse(x);
+  x = mul_filter::reverse(x);
+  x = rot_filter::reverse(x);
+  x = xor_filter::reverse(x);
+  return add_filter::reverse(x);
+}
+
+using branch_t = pipet::pipe<xor_filter, mul_filter>;
+using fanout_t = pipet::pipe<
+    add_filter,
+    pipet::branches<pipet::placeholders::self, branch_t, branch_t, branch_t>,
+    sum4_filter>;
+
+uint64_t hand_fanout(uint64_t x) {
+  x = add_filter::process(x);
+  auto const b = mul_filter::process(xor_filter::process(x));
+  return sum4_filter::process(x, b, b, b);
+}
+
+// aes s-box as a pipe (inversion in GF(2^8) then affine map), computed on
+// each call unless tabulated
+constexpr uint8_t gf_mul(uint8_t a, uint8_t b) {
+  uint8_t r = 0;
+  for (; b; b >>= 1) {
+    if (b & 1) {
+      r ^= a;
+    }
+    a = static_cast<uint8_t>((a << 1) ^ ((a & 0x80) ? 0x1b : 0));
+  }
+  return r;
+}
+
+constexpr uint8_t rotl8(uint8_t x, int n) {
+  return static_cast<uint8_t>((x << n) | (x >> (8 - n)));
+}
+
+struct gf_inv_filter {
+  // x^254, 0 maps to 0
+  static constexpr uint8_t process(uint8_t x) {
+    uint8_t r = 1;
+    for (uint8_t e = 254; e; e >>= 1) {
+      if (e & 1) {
+        r = gf_mul(r, x);
+      }
+      x = gf_mul(x, x);
+    }
+    return r;
+  }
+  static constexpr uint8_t reverse(uint8_t x) { return process(x); }
+};
+
+struct affine_filter {
+  static constexpr uint8_t process(uint8_t x) {
+    return x ^ rotl8(x, 1) ^ rotl8(x, 2) ^ rotl8(x, 3) ^ rotl8(x, 4) ^ 0x63;
+  }
+  static constexpr uint8_t reverse(uint8_t x) {
+    return rotl8(x, 1) ^ rotl8(x, 3) ^ rotl8(x, 6) ^ 0x05;
+  }
+};
+
+using sbox_t = pipet::pipe<gf_inv_filter, affine_filter>;
+using sbox_table_t = pipet::tabulate<sbox_t>;
+
+// generator prefix: constexpr seed and mixing stages, then a runtime stage
+uint64_t g_seed = 42;
+uint64_t g_salt = 7;
+
+struct seed_gen {
+  static constexpr uint64_t process() { return 42; }
+};
+
+// same seed not known at compile time, nothing can be folded
+struct seed_gen_rt {
+  static uint64_t process() { return g_seed; }
+};
+
+template <std::size_t I> struct mix_stage {
+  static constexpr uint64_t process(uint64_t x) {
+    for (int i = 0; i < 16; ++i) {
+      x = (x ^ (x >> 31)) * 0xbf58476d1ce4e5b9ull;
+    }
+    return x + I;
+  }
+};
+
+struct salt_stage {
+  static uint64_t process(uint64_t x) { return x ^ g_salt; }
+};
+
+template <typename G, std::size_t... Is>
+auto make_gen_pipe(std::index_sequence<Is...>)
+    -> pipet::pipe<G, mix_stage<Is>..., salt_stage>;
+
+template <typename G, std::size_t N>
+using gen_pipe_t = decltype(make_gen_pipe<G>(std::make_index_sequence<N>{}));
+
+// mixing stage the compiler can neither fold nor merge
+template <std::size_t I> struct opaque_mix_stage {
+  static uint64_t process(uint64_t x) {
+    bench::clobber(x);
+    return mix_stage<I>::process(x);
+  }
+};
+
+// wide fan-out with a common 2 stages prefix, evaluated once by the pipe
+template <std::size_t I>
+using prefixed_branch_t =
+    pipet::pipe<opaque_mix_stage<0>, opaque_mix_stage<1>, opaque_mix_stage<I>>;
+
+using shared_fanout_t = pipet::pipe<
+    add_filter,
+    pipet::branches<prefixed_branch_t<2>, prefixed_branch_t<3>,
+                    prefixed_branch_t<4>, prefixed_branch_t<5>>,
+    sum4_filter>;
+
+// same fan-out, each branch computed on its own
+uint64_t hand_unshared_fanout(uint64_t x) {
+  x = add_filter::process(x);
+  auto const b = [x](auto last) {
+    return decltype(last)::process(
+        opaque_mix_stage<1>::process(opaque_mix_stage<0>::process(x)));
+  };
+  return sum4_filter::process(
+      b(opaque_mix_stage<2>{}), b(opaque_mix_stage<3>{}),
+      b(opaque_mix_stage<4>{}), b(opaque_mix_stage<5>{}));
+}
+
+// pipe assembled from fragments: encode/decode pair and constant xors left
+// to the optimization pass
+struct encode_filter {
+  static uint64_t process(uint64_t x) {
+    bench::clobber(x);
+    for (int i = 0; i < 16; ++i) {
+      x = ((x << 17) | (x >> 47)) + 0x9e3779b97f4a7c15ull;
+    }
+    return x;
+  }
+  static uint64_t reverse(uint64_t x) {
+    bench::clobber(x);
+    for (int i = 0; i < 16; ++i) {
+      x -= 0x9e3779b97f4a7c15ull;
+      x = (x >> 17) | (x << 47);
+    }
+    return x;
+  }
+};
+
+template <uint64_t K> struct xor_key_filter {
+  static uint64_t process(uint64_t x) {
+    bench::clobber(x);
+    return x ^ K;
+  }
+  static uint64_t reverse(uint64_t x) { return process(x); }
+};
+} // namespace
+
+namespace pipet::traits {
+template <uint64_t A, uint64_t B>
+struct compose<xor_key_filter<A>, xor_key_filter<B>> {
+  using type = xor_key_filter<A ^ B>;
+};
+} // namespace pipet::traits
+
+namespace {
+template <template <typename...> typename P>
+using fragments_t =
+    P<opaque_mix_stage<0>, encode_filter, pipet::inverse<encode_filter>,
+      xor_key_filter<1>, xor_key_filter<2>, xor_key_filter<4>, salt_stage>;
+
+struct suite {
+  bench::options opts;
+  char const *filter{nullptr};
+  std::vector<bench::result> results;
+
+  template <typename F>
+  void add(std::string name, F &&f, std::size_t bytes_per_call = 0) {
+    if (filter && name.find(filter) == std::string::npos) {
+      return;
+    }
+    std::cerr << "running " << name << "..." << std::endl;
+    results.push_back(
+        bench::run(std::move(name), std::forward<F>(f), opts, bytes_per_call));
+  }
+};
+
+template <std::size_t N> void gen_prefix_benchmarks(suite &s) {
+  auto const depth = std::to_string(N);
+
+  s.add("pipe/gen_prefix/" + depth + "/folded", [&] {
+    bench::clobber(g_salt);
+    bench::do_not_optimize(gen_pipe_t<seed_gen, N>::process());
+  });
+  s.add("pipe/gen_prefix/" + depth + "/runtime", [&] {
+    bench::clobber(g_seed);
+    bench::clobber(g_salt);
+    bench::do_not_optimize(gen_pipe_t<seed_gen_rt, N>::process());
+  });
+}
+
+void pipe_benchmarks(suite &s) {
+  uint64_t x = 42;
+
+  s.add("pipe/chain8/process", [&] {
+    bench::clobber(x);
+    bench::do_not_optimize(chain_t::process(x));
+  });
+  s.add("hand/chain8/process", [&] {
+    bench::clobber(x);
+    bench::do_not_optimize(hand_chain(x));
+  });
+  s.add("pipe/chain8/reverse", [&] {
+    bench::clobber(x);
+    bench::do_not_optimize(chain_t::reverse(x));
+  });
+  s.add("hand/chain8/reverse", [&] {
+    bench::clobber(x);
+    bench::do_not_optimize(hand_chain_reverse(x));
+  });
+  s.add("pipe/fanout4/process", [&] {
+    bench::clobber(x);
+    bench::do_not_optimize(fanout_t::process(x));
+  });
+  s.add("hand/fanout4/process", [&] {
+    bench::clobber(x);
+    bench::do_not_optimize(hand_fanout(x));
+  });
+
+  s.add("pipe/fanout4_prefix/process", [&] {
+    bench::clobber(x);
+    bench::do_not_optimize(shared_fanout_t::process(x));
+  });
+  s.add("hand/fanout4_prefix/unshared", [&] {
+    bench::clobber(x);
+    bench::do_not_optimize(hand_unshared_fanout(x));
+  });
+
+  // optimization pass against the same filters run as written
+  s.add("pipe/fragments7/optimized", [&] {
+    bench::clobber(x);
+    bench::do_not_optimize(fragments_t<pipet::pipe>::process(x));
+  });
+  s.add("pipe/fragments7/as_written", [&] {
+    bench::clobber(x);
+    bench::do_not_optimize(fragments_t<pipet::detail::pipe_impl>::process(x));
+  });
+
+  // constant generator prefix, per call cost independent of its depth
+  gen_prefix_benchmarks<1>(s);
+  gen_prefix_benchmarks<8>(s);
+  gen_prefix_benchmarks<32>(s);
+}
+
+void tabulate_benchmarks(suite &s) {
+  std::vector<uint8_t> in(4096), out(4096);
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    in[i] = static_cast<uint8_t>(i * 31);
+  }
+
+  s.add("tabulate/sbox/pipe/process/4096",
+        [&] {
+          sbox_t::process_batch(in, out);
+          bench::do_not_optimize(out.data());
+        },
+        in.size());
+  s.add("tabulate/sbox/table/process/4096",
+        [&] {
+          sbox_table_t::process_batch(in, out);
+          bench::do_not_optimize(out.data());
+        },
+        in.size());
+  s.add("tabulate/sbox/pipe/reverse/4096",
+        [&] {
+          sbox_t::reverse_batch(in, out);
+          bench::do_not_optimize(out.data());
+        },
+        in.size());
+  s.add("tabulate/sbox/table/reverse/4096",
+        [&] {
+          sbox_table_t::reverse_batch(in, out);
+          bench::do_not_optimize(out.data());
+        },
+        in.size());
+}
+
+// previous aes key schedule (inheritance chain walked on each round key
+// access) and round loop, reference for the flat key schedule
+using aes::operator^;
+
+template <std::size_t N> struct chained_exp_key : chained_exp_key<N - 1> {
+  constexpr chained_exp_key(aes::serial_key const &k)
+      : chained_exp_key<N - 1>(k), c0{chained_exp_key<N - 1>::c0 ^
+                                      aes::detail::g(
+                                          chained_exp_key<N - 1>::c3, N)},
+        c1{c0 ^ chained_exp_key<N - 1>::c1},
+        c2{c1 ^ chained_exp_key<N - 1>::c2},
+        c3{c2 ^ chained_exp_key<N - 1>::c3} {}
+
+  constexpr auto get_at(std::size_t i) const {
+    return ((i == N) ? aes::key{c0, c1, c2, c3}
+                     : chained_exp_key<N - 1>::get_at(i));
+  }
+
+  aes::word const c0;
+  aes::word const c1;
+  aes::word const c2;
+  aes::word const c3;
+};
+
+template <> struct chained_exp_key<0> {
+  constexpr chained_exp_key(aes::serial_key const &k)
+      : c0{k[0], k[1], k[2], k[3]}, c1{k[4], k[5], k[6], k[7]},
+        c2{k[8], k[9], k[10], k[11]}, c3{k[12], k[13], k[14], k[15]} {}
+
+  constexpr auto get_at(std::size_t) const {
+    return aes::key{c0, c1, c2, c3};
+  }
+
+  aes::word const c0;
+  aes::word const c1;
+  aes::word const c2;
+  aes::word const c3;
+};
+
+class chained_aes_cipher {
+  using round_pipe = pipet::pipe<aes::subbyte_filter, aes::shiftrow_filter,
+                                 aes::mixcol_filter>;
+  using last_round_pipe = pipet::helpers::pop_back_t<round_pipe>;
+
+  chained_exp_key<10> const m_k;
+
+public:
+  chained_aes_cipher(aes::serial_key const &k) : m_k{k} {}
+
+  aes::state cipher(aes::state s) const {
+    for (auto i = 0; i <= 8; ++i) {
+      s = round_pipe::process(aes::inject_key(s, m_k.get_at(i)));
+    }
+
+    return aes::inject_key(
+        last_round_pipe::process(aes::inject_key(s, m_k.get_at(9))),
+        m_k.get_at(10));
+  }
+
+  aes::state decipher(aes::state s) const {
+    s = last_round_pipe::reverse(aes::inject_key(s, m_k.get_at(10)));
+
+    for (auto i = 9; i >= 1; --i) {
+      s = round_pipe::reverse(aes::inject_key(s, m_k.get_at(i)));
+    }
+
+    return aes::inject_key(s, m_k.get_at(0));
+  }
+};
+
+// blocks ciphered one after the other (bytes per call / 16 blocks per call)
+template <typename Cipher>
+void add_aes_ecb(suite &s, std::string const &name, Cipher const &c,
+                 std::vector<aes::state> &blocks) {
+  s.add(name + "/cipher/" + std::to_string(blocks.size()),
+        [&] {
+          for (auto &b : blocks) {
+            b = c.cipher(b);
+          }
+          bench::do_not_optimize(blocks.data());
+        },
+        blocks.size() * sizeof(aes::state));
+  s.add(name + "/decipher/" + std::to_string(blocks.size()),
+        [&] {
+          for (auto &b : blocks) {
+            b = c.decipher(b);
+          }
+          bench::do_not_optimize(blocks.data());
+        },
+        blocks.size() * sizeof(aes::state));
+}
+
+void aes_benchmarks(suite &s) {
+  aes::serial_key const kraw = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae,
+                                0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88,
+                                0x09, 0xcf, 0x4f, 0x3c};
+  auto const encryptor = aes::basic_aes_cipher<>{kraw};
+  auto block = aes::state{{0x32, 0x43, 0xf6, 0xa8},
+                          {0x88, 0x5a, 0x30, 0x8d},
+                          {0x31, 0x31, 0x98, 0xa2},
+                          {0xe0, 0x37, 0x07, 0x34}};
+
+  s.add("aes/block/cipher",
+        [&] {
+          bench::clobber(block);
+          bench::do_not_optimize(encryptor.cipher(block));
+        },
+        sizeof(aes::state));
+  s.add("aes/block/decipher",
+        [&] {
+          bench::clobber(block);
+          bench::do_not_optimize(encryptor.decipher(block));
+        },
+        sizeof(aes::state));
+
+  // rounds run in a loop, 3 rounds per iteration or one by one
+  auto const encryptor3 = aes::basic_aes_cipher<3>{kraw};
+  auto const encryptor1 = aes::basic_aes_cipher<1>{kraw};
+  s.add("aes/block/cipher/unroll3",
+        [&] {
+          bench::clobber(block);
+          bench::do_not_optimize(encryptor3.cipher(block));
+        },
+        sizeof(aes::state));
+  s.add("aes/block/cipher/unroll1",
+        [&] {
+          bench::clobber(block);
+          bench::do_not_optimize(encryptor1.cipher(block));
+        },
+        sizeof(aes::state));
+
+  // flat key schedule against the chained one
+  static std::vector<aes::state> blocks(256, block);
+  add_aes_ecb(s, "aes/ecb/flat_keys", encryptor, blocks);
+  static chained_aes_cipher const chained{kraw};
+  add_aes_ecb(s, "aes/ecb/chained_keys", chained, blocks);
+
+  // t-table rounds
+  static aes::ttable_aes_cipher const ttable{kraw};
+  add_aes_ecb(s, "aes/ecb/ttable", ttable, blocks);
+
+  // bitsliced blocks, whole buffer per call then through a pipe batch
+  static aes::bitsliced_aes_cipher const bitsliced{kraw};
+  s.add("aes/ecb/bitsliced/cipher/" + std::to_string(blocks.size()),
+        [&] {
+          bitsliced.cipher_blocks(blocks, blocks);
+          bench::do_not_optimize(blocks.data());
+        },
+        blocks.size() * sizeof(aes::state));
+  s.add("aes/ecb/bitsliced/decipher/" + std::to_string(blocks.size()),
+        [&] {
+          bitsliced.decipher_blocks(blocks, blocks);
+          bench::do_not_optimize(blocks.data());
+        },
+        blocks.size() * sizeof(aes::state));
+
+  // aes-ni backend (pipe fallback without cpu support), block by block and
+  // 8 blocks interleaved
+  static aes::aes_cipher const aesni{kraw};
+  add_aes_ecb(s, "aes/ecb/aesni_block", aesni, blocks);
+  s.add("aes/ecb/aesni/cipher/" + std::to_string(blocks.size()),
+        [&] {
+          aesni.cipher_blocks(blocks, blocks);
+          bench::do_not_optimize(blocks.data());
+        },
+        blocks.size() * sizeof(aes::state));
+  s.add("aes/ecb/aesni/decipher/" + std::to_string(blocks.size()),
+        [&] {
+          aesni.decipher_blocks(blocks, blocks);
+          bench::do_not_optimize(blocks.data());
+        },
+        blocks.size() * sizeof(aes::state));
+
+  using bitsliced_pipe = pipet::pipe<aes::bitsliced_aes_filter>;
+  static aes::exp_key<10> const keys{kraw};
+  static std::vector<aes::keyed_state> keyed(
+      blocks.size(), aes::keyed_state{block, keys.keys.data()});
+  s.add("aes/ecb/bitsliced_pipe/cipher/" + std::to_string(keyed.size()),
+        [&] {
+          bitsliced_pipe::process_batch(keyed, keyed);
+          bench::do_not_optimize(keyed.data());
+        },
+        keyed.size() * sizeof(aes::state));
+}
+
+// bulk modes on 16 MiB, t threads: t - 1 pool workers and the calling
+// thread (helping the pool while waiting for the chunks)
+void aes_mode_benchmarks(suite &s) {
+  aes::serial_key const kraw = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae,
+                                0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88,
+                                0x09, 0xcf, 0x4f, 0x3c};
+  aes::serial_state const iv = {0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5,
+                                0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb,
+                                0xfc, 0xfd, 0xfe, 0xff};
+  std::vector<uint8_t> const in(16 << 20, 0x5a);
+  std::vector<uint8_t> out(in.size());
+
+  for (std::size_t t : {1, 2, 4, 8, 16}) {
+    pipet::helpers::thread_pool pool{t - 1};
+    auto const suffix = "/threads" + std::to_string(t) + "/16MiB";
+
+    s.add("aes/ctr" + suffix,
+          [&] {
+            aes::aes_ctr(kraw, iv, in, out, pool);
+            bench::do_not_optimize(out.data());
+          },
+          in.size());
+    s.add("aes/cbc_decipher" + suffix,
+          [&] {
+            aes::aes_cbc_decipher(kraw, iv, in, out, pool);
+            bench::do_not_optimize(out.data());
+          },
+          in.size());
+  }
+}
+
+void strobfs_benchmarks(suite &s) {
+  // short strings use the single xor pipe, longer ones the 3 filters pipe
+  constexpr auto cipher1 = strobfs::obfuscate(
+      pipet::extra::make_cxstring("copyright"));
+  constexpr auto cipher2 = strobfs::obfuscate(
+      pipet::extra::make_cxstring("enter password"));
+  // cxstring is immutable, its address is made opaque instead
+  auto const *in1 = &cipher1;
+  auto const *in2 = &cipher2;
+
+  s.add("strobfs/deobfuscate/9", [&] {
+    bench::clobber(in1);
+    bench::do_not_optimize(strobfs::deobfuscate(*in1));
+  });
+  s.add("strobfs/deobfuscate/14", [&] {
+    bench::clobber(in2);
+    bench::do_not_optimize(strobfs::deobfuscate(*in2));
+  });
+}
+
+// throughput of the engines (one value, 4096 values)
+template <typename Engine>
+void engine_benchmarks(suite &s, std::string const &name) {
+  Engine gen;
+  using value_type = typename Engine::result_type;
+  std::vector<value_type> buffer(4096);
+
+  s.add("random/" + name + "/next",
+        [&] { bench::do_not_optimize(gen.next()); });
+  s.add("random/" + name + "/fill/4096",
+        [&] {
+          gen.fill(buffer);
+          bench::do_not_optimize(buffer.data());
+        },
+        buffer.size() * sizeof(value_type));
+}
+
+void random_benchmarks(suite &s) {
+  // jump ahead, per value cost grows with log2(round) only
+  auto const gen = pipet::extra::minstand_lcg<uint32_t>{};
+  for (auto const shift : {0, 6, 16, 24, 32}) {
+    auto round = std::size_t{1} << shift;
+    s.add("random/minstand_lcg/rand/2^" + std::to_string(shift), [&] {
+      bench::clobber(round);
+      bench::do_not_optimize(gen.rand(round));
+    });
+  }
+
+  auto stream = pipet::extra::minstand_lcg<uint32_t>{};
+  s.add("random/minstand_lcg/next",
+        [&] { bench::do_not_optimize(stream.next()); });
+
+  // batch generation, leapfrogged simd lanes against repeated next calls
+  std::vector<uint32_t> buffer(4096);
+  s.add("random/minstand_lcg/next_loop/4096",
+        [&] {
+          for (auto &v : buffer) {
+            v = stream.next();
+          }
+          bench::do_not_optimize(buffer.data());
+        },
+        buffer.size() * sizeof(uint32_t));
+  s.add("random/minstand_lcg/fill/4096",
+        [&] {
+          stream.fill(buffer);
+          bench::do_not_optimize(buffer.data());
+        },
+        buffer.size() * sizeof(uint32_t));
+
+  std::size_t skip = std::size_t{1} << 32;
+  s.add("random/minstand_lcg/discard/2^32", [&] {
+    bench::clobber(skip);
+    stream.discard(skip);
+    bench::do_not_optimize(stream.state());
+  });
+
+  engine_benchmarks<pipet::extra::splitmix64>(s, "splitmix64");
+  engine_benchmarks<pipet::extra::xoshiro256ss>(s, "xoshiro256ss");
+  engine_benchmarks<pipet::extra::pcg32>(s, "pcg32");
+
+  // k distinct bits masks (Floyd's sampling)
+  pipet::extra::pcg32 sampler_gen;
+  std::vector<uint64_t> masks(1024);
+  s.add("random/sample_unique_mask/8of64/fill/1024", [&] {
+    pipet::extra::sample_unique_mask<8>::fill(sampler_gen, masks);
+    bench::do_not_optimize(masks.data());
+  });
+  std::vector<pipet::extra::sample_unique<16, 100000>::index_array> samples(
+      1024);
+  s.add("random/sample_unique/16of100000/fill/1024", [&] {
+    pipet::extra::sample_unique<16, 100000>::fill(sampler_gen, samples);
+    bench::do_not_optimize(samples.data());
+  });
+}
+
+void bit_benchmarks(suite &s) {
+  // 32 KiB bitmaps
+  auto gen = pipet::extra::splitmix64{};
+  std::vector<uint64_t> a(4096), b(4096), out(4096);
+  gen.fill(a);
+  gen.fill(b);
+  auto const bytes = a.size() * sizeof(uint64_t);
+
+  s.add("bit/bit_count/portable/4096",
+        [&] {
+          auto const *p = a.data();
+          bench::clobber(p);
+          bench::do_not_optimize(pipet::extra::detail::count_portable(
+              pipet::extra::detail::plain_loader{p}, a.size()));
+        },
+        bytes);
+  s.add("bit/bit_count/4096",
+        [&] {
+          bench::clobber(a);
+          bench::do_not_optimize(pipet::extra::bit_count(a));
+        },
+        bytes);
+  s.add("bit/bit_count_and/4096",
+        [&] {
+          bench::clobber(a);
+          bench::do_not_optimize(pipet::extra::bit_count_and(a, b));
+        },
+        bytes);
+  s.add("bit/bit_and/4096",
+        [&] {
+          pipet::extra::bit_and(a, b, out);
+          bench::do_not_optimize(out.data());
+        },
+        bytes);
+
+  std::size_t found = 0;
+  s.add("bit/for_each_set_bit/4096", [&] {
+    pipet::extra::for_each_set_bit(a, [&](std::size_t i) { found += i; });
+    bench::do_not_optimize(found);
+  });
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  suite s;
+  char const *out_path = nullptr;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--filter") && i + 1 < argc) {
+      s.filter = argv[++i];
+    } else if (!std::strcmp(argv[i], "--reps") && i + 1 < argc) {
+      s.opts.repetitions = std::strtoul(argv[++i], nullptr, 10);
+    } else {
+      out_path = argv[i];
+    }
+  }
+
+  pipe_benchmarks(s);
+  tabulate_benchmarks(s);
+  aes_benchmarks(s);
+  aes_mode_benchmarks(s);
+  strobfs_benchmarks(s);
+  random_benchmarks(s);
+  bit_benchmarks(s);
+
+  if (out_path) {
+    std::ofstream os{out_path};
+    bench::write_json(os, s.results, s.opts);
+  } else {
+    bench::write_json(std::cout, s.results, s.opts);
+  }
+
+  return 0;
+}
\ No newline at end of file
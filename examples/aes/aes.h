@@ -14,13 +14,19 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstring>
 #include <tuple>
 #include <type_traits>
 #include <vector>
 
+#include "aesni.h"
+#include "bitslice.h"
+#include "pipet/helpers/span.h"
 #include "pipet/pipet.h"
+#include "pipet/repeat.h"
 #include "tables.h"
 
 //
@@ -48,6 +54,10 @@ struct mat4x4 {
 using state = mat4x4;
 using key = mat4x4;
 
+// state or round key as 4 columns packed in 32-bit big endian words (t-table
+// implementation)
+using word_block = std::array<uint32_t, 4>;
+
 namespace detail {
 // aes implementation details
 
@@ -183,44 +193,100 @@ constexpr bool equals(std::array<T, N> const &rhs,
   return detail::equal_array(rhs, lhs, std::make_index_sequence<N>{});
 }
 
-// expanded key
-template <std::size_t N> struct exp_key : exp_key<N - 1> {
-  constexpr exp_key(serial_key key)
-      : exp_key<N - 1>(key), c0{exp_key<N - 1>::c0 ^
-                                detail::g(exp_key<N - 1>::c3, N)},
-        c1{c0 ^ exp_key<N - 1>::c1}, c2{c1 ^ exp_key<N - 1>::c2},
-        c3{c2 ^ exp_key<N - 1>::c3} {}
+namespace detail {
+// key schedule details (aes 128: a round key is 4 words, word i of the
+// schedule derived from words i - 4 and i - 1)
+
+template <std::size_t N> using key_schedule = std::array<key, N + 1>;
 
-  constexpr auto serial_at(std::size_t i) const {
-    return ((i == N) ? detail::serialize_key(c0, c1, c2, c3)
-                     : exp_key<N - 1>::serial_at(i));
+template <std::size_t N> using word_schedule = std::array<word_block, N + 1>;
+
+constexpr uint32_t pack_word(word const &w) {
+  return (uint32_t{w[0]} << 24) | (uint32_t{w[1]} << 16) |
+         (uint32_t{w[2]} << 8) | uint32_t{w[3]};
+}
+
+constexpr word unpack_word(uint32_t w) {
+  return word{static_cast<uint8_t>(w >> 24), static_cast<uint8_t>(w >> 16),
+              static_cast<uint8_t>(w >> 8), static_cast<uint8_t>(w)};
+}
+
+constexpr word_block pack_block(mat4x4 const &m) {
+  return word_block{pack_word(m.c0), pack_word(m.c1), pack_word(m.c2),
+                    pack_word(m.c3)};
+}
+
+constexpr mat4x4 unpack_block(word_block const &b) {
+  return mat4x4{unpack_word(b[0]), unpack_word(b[1]), unpack_word(b[2]),
+                unpack_word(b[3])};
+}
+
+template <std::size_t N>
+constexpr key_schedule<N> expand_key(serial_key const &k) {
+  key_schedule<N> res{};
+  res[0] = key{{k[0], k[1], k[2], k[3]},
+               {k[4], k[5], k[6], k[7]},
+               {k[8], k[9], k[10], k[11]},
+               {k[12], k[13], k[14], k[15]}};
+
+  for (std::size_t r = 1; r <= N; ++r) {
+    res[r].c0 = res[r - 1].c0 ^ g(res[r - 1].c3, r);
+    res[r].c1 = res[r].c0 ^ res[r - 1].c1;
+    res[r].c2 = res[r].c1 ^ res[r - 1].c2;
+    res[r].c3 = res[r].c2 ^ res[r - 1].c3;
   }
+  return res;
+}
 
-  constexpr auto get_at(std::size_t i) const {
-    return ((i == N) ? key{c0, c1, c2, c3} : exp_key<N - 1>::get_at(i));
+// decryption keys in order of use, InvMixColumns applied to the inner round
+// keys (equivalent inverse cipher)
+template <std::size_t N>
+constexpr key_schedule<N> inverse_schedule(key_schedule<N> const &keys) {
+  key_schedule<N> res{};
+  res[0] = keys[N];
+  for (std::size_t r = 1; r < N; ++r) {
+    auto const &k = keys[N - r];
+    res[r] = key{mixcol_inv(k.c0), mixcol_inv(k.c1), mixcol_inv(k.c2),
+                 mixcol_inv(k.c3)};
   }
+  res[N] = keys[0];
+  return res;
+}
 
-  word const c0;
-  word const c1;
-  word const c2;
-  word const c3;
-};
+template <std::size_t N>
+constexpr word_schedule<N> pack_schedule(key_schedule<N> const &keys) {
+  word_schedule<N> res{};
+  for (std::size_t r = 0; r <= N; ++r) {
+    res[r] = pack_block(keys[r]);
+  }
+  return res;
+}
+} // namespace detail
 
-template <> struct exp_key<0> {
+// expanded key (N rounds), flat round keys with O(1) access
+template <std::size_t N> struct exp_key {
   constexpr exp_key(serial_key const &k)
-      : c0{k[0], k[1], k[2], k[3]}, c1{k[4], k[5], k[6], k[7]},
-        c2{k[8], k[9], k[10], k[11]}, c3{k[12], k[13], k[14], k[15]} {}
+      : keys{detail::expand_key<N>(k)},
+        dec_keys{detail::inverse_schedule<N>(keys)},
+        words{detail::pack_schedule<N>(keys)},
+        dec_words{detail::pack_schedule<N>(dec_keys)} {}
 
   constexpr auto serial_at(std::size_t i) const {
-    return detail::serialize_key(c0, c1, c2, c3);
+    return detail::serialize_key(keys[i].c0, keys[i].c1, keys[i].c2,
+                                 keys[i].c3);
   }
 
-  constexpr auto get_at(std::size_t i) const { return key{c0, c1, c2, c3}; }
+  constexpr key const &get_at(std::size_t i) const { return keys[i]; }
 
-  word const c0;
-  word const c1;
-  word const c2;
-  word const c3;
+  // round keys (encryption order)
+  alignas(16) detail::key_schedule<N> const keys;
+
+  // round keys of the equivalent inverse cipher (decryption order)
+  alignas(16) detail::key_schedule<N> const dec_keys;
+
+  // same as blocks of 32-bit big endian words
+  alignas(16) detail::word_schedule<N> const words;
+  alignas(16) detail::word_schedule<N> const dec_words;
 };
 
 // Base state passed from filter to filter
@@ -235,6 +301,10 @@ constexpr auto inject_key(state const &s, key const &rk) {
   };
 }
 
+constexpr auto inject_key(word_block const &s, word_block const &rk) {
+  return s ^ rk;
+}
+
 // Filters
 struct subbyte_filter {
   static constexpr auto process(state const &s) {
@@ -288,37 +358,420 @@ struct mixcol_filter {
   }
 };
 
-// Aes base class
-class aes_cipher {
-  using round_pipe =
-      pipet::pipe<subbyte_filter, shiftrow_filter, mixcol_filter>;
-  using last_round_pipe = pipet::helpers::pop_back_t<round_pipe>;
+// Round keys (encryption or decryption schedule) carried along the state
+// through the cipher pipes
+template <typename State> struct basic_keyed_state {
+  State s;
+  State const *keys;
+};
+
+using keyed_state = basic_keyed_state<state>;
+using keyed_block = basic_keyed_state<word_block>;
 
+// state filter applied to a keyed state
+template <typename F, typename KS = keyed_state> struct keyed_filter {
+  static constexpr KS process(KS const &ks) {
+    return KS{F::process(ks.s), ks.keys};
+  }
+
+  static constexpr KS reverse(KS const &ks) {
+    return KS{F::reverse(ks.s), ks.keys};
+  }
+};
+
+// injection of round key I
+template <std::size_t I, typename KS = keyed_state> struct key_filter {
+  static constexpr KS process(KS const &ks) {
+    return KS{inject_key(ks.s, ks.keys[I]), ks.keys};
+  }
+
+  static constexpr KS reverse(KS const &ks) { return process(ks); }
+};
+
+// injection of the key of the current round (given by pipet::repeat)
+template <typename KS = keyed_state> struct round_key_filter {
+  static constexpr KS process(KS const &ks, std::size_t round) {
+    return KS{inject_key(ks.s, ks.keys[round + 1]), ks.keys};
+  }
+
+  static constexpr KS reverse(KS const &ks, std::size_t round) {
+    return process(ks, round);
+  }
+};
+
+// Aes base class (Unroll rounds per loop iteration, 9 for a fully unrolled
+// cipher)
+template <std::size_t Unroll = 9> class basic_aes_cipher {
+  using round_pipe = pipet::round_pipe<
+      keyed_filter<subbyte_filter>, keyed_filter<shiftrow_filter>,
+      keyed_filter<mixcol_filter>, round_key_filter<>>;
+  using cipher_pipe =
+      pipet::pipe<key_filter<0>, pipet::repeat<round_pipe, 9, Unroll>,
+                  keyed_filter<subbyte_filter>, keyed_filter<shiftrow_filter>,
+                  key_filter<10>>;
+
+  // equivalent inverse cipher, same structure as the cipher
+  using inv_round_pipe = pipet::round_pipe<
+      keyed_filter<pipet::inverse<subbyte_filter>>,
+      keyed_filter<pipet::inverse<shiftrow_filter>>,
+      keyed_filter<pipet::inverse<mixcol_filter>>, round_key_filter<>>;
+  using decipher_pipe = pipet::pipe<
+      key_filter<0>, pipet::repeat<inv_round_pipe, 9, Unroll>,
+      keyed_filter<pipet::inverse<subbyte_filter>>,
+      keyed_filter<pipet::inverse<shiftrow_filter>>, key_filter<10>>;
+
+protected:
   exp_key<10> const m_k;
 
 public:
-  constexpr aes_cipher(serial_key const &k) : m_k{k} {}
+  constexpr basic_aes_cipher(serial_key const &k) : m_k{k} {}
 
   constexpr auto cipher(state s) const {
-    for (auto i = 0; i <= 8; ++i) {
-      s = round_pipe::process(inject_key(s, m_k.get_at(i)));
-    }
+    return cipher_pipe::process(keyed_state{s, m_k.keys.data()}).s;
+  }
+
+  constexpr auto decipher(state s) const {
+    return decipher_pipe::process(keyed_state{s, m_k.dec_keys.data()}).s;
+  }
+};
+
+namespace detail {
+// t-table details: SubBytes, ShiftRows and MixColumns of a round fused into
+// 4 table lookups per column, table i holding the MixColumns column of the
+// substituted byte of row i (decryption tables: InvSubBytes, InvShiftRows
+// and InvMixColumns of the equivalent inverse cipher)
+
+using ttable = std::array<uint32_t, 256>;
+
+constexpr uint8_t byte_at(uint32_t w, std::size_t row) {
+  return static_cast<uint8_t>(w >> (24 - 8 * row));
+}
+
+constexpr uint32_t rotr(uint32_t w, std::size_t bytes) {
+  return bytes ? (w >> (8 * bytes)) | (w << (32 - 8 * bytes)) : w;
+}
+
+constexpr uint8_t sbox(uint8_t x) { return sbox_table[x >> 4][x & 0xF]; }
 
-    return inject_key(last_round_pipe::process(inject_key(s, m_k.get_at(9))),
-                      m_k.get_at(10));
+constexpr uint8_t sbox_inv(uint8_t x) {
+  return sbox_inv_table[x >> 4][x & 0xF];
+}
+
+template <std::size_t... Is>
+constexpr std::array<ttable, 4> make_ttables(bool inv,
+                                             std::index_sequence<Is...>) {
+  std::array<ttable, 4> res{};
+  for (std::size_t x = 0; x < 256; ++x) {
+    auto const v = static_cast<uint8_t>(x);
+    auto const col = inv ? pack_word(mixcol_inv(word{sbox_inv(v), 0, 0, 0}))
+                         : pack_word(mixcol(word{sbox(v), 0, 0, 0}));
+    ((res[Is][x] = rotr(col, Is)), ...);
+  }
+  return res;
+}
+
+alignas(64) inline constexpr std::array<ttable, 4> te_tables =
+    make_ttables(false, std::make_index_sequence<4>{});
+
+alignas(64) inline constexpr std::array<ttable, 4> td_tables =
+    make_ttables(true, std::make_index_sequence<4>{});
+
+// column c of a t-table round, row i read from column c + Shift * i
+template <std::size_t Shift>
+constexpr uint32_t ttable_column(std::array<ttable, 4> const &t,
+                                 word_block const &s, std::size_t c) {
+  return t[0][byte_at(s[c], 0)] ^ t[1][byte_at(s[(c + Shift) % 4], 1)] ^
+         t[2][byte_at(s[(c + 2 * Shift) % 4], 2)] ^
+         t[3][byte_at(s[(c + 3 * Shift) % 4], 3)];
+}
+
+// last round column (no MixColumns)
+template <std::size_t Shift, typename Box>
+constexpr uint32_t last_column(Box const &box, word_block const &s,
+                               std::size_t c) {
+  return pack_word(word{box(byte_at(s[c], 0)),
+                        box(byte_at(s[(c + Shift) % 4], 1)),
+                        box(byte_at(s[(c + 2 * Shift) % 4], 2)),
+                        box(byte_at(s[(c + 3 * Shift) % 4], 3))});
+}
+} // namespace detail
+
+// Word filters (t-table implementation)
+
+// SubBytes, ShiftRows and MixColumns
+struct ttable_round_filter {
+  static constexpr word_block process(word_block const &s) {
+    return word_block{detail::ttable_column<1>(detail::te_tables, s, 0),
+                      detail::ttable_column<1>(detail::te_tables, s, 1),
+                      detail::ttable_column<1>(detail::te_tables, s, 2),
+                      detail::ttable_column<1>(detail::te_tables, s, 3)};
+  }
+};
+
+// SubBytes and ShiftRows
+struct ttable_last_round_filter {
+  static constexpr word_block process(word_block const &s) {
+    return word_block{detail::last_column<1>(detail::sbox, s, 0),
+                      detail::last_column<1>(detail::sbox, s, 1),
+                      detail::last_column<1>(detail::sbox, s, 2),
+                      detail::last_column<1>(detail::sbox, s, 3)};
+  }
+};
+
+// InvSubBytes, InvShiftRows and InvMixColumns
+struct ttable_inv_round_filter {
+  static constexpr word_block process(word_block const &s) {
+    return word_block{detail::ttable_column<3>(detail::td_tables, s, 0),
+                      detail::ttable_column<3>(detail::td_tables, s, 1),
+                      detail::ttable_column<3>(detail::td_tables, s, 2),
+                      detail::ttable_column<3>(detail::td_tables, s, 3)};
+  }
+};
+
+// InvSubBytes and InvShiftRows
+struct ttable_inv_last_round_filter {
+  static constexpr word_block process(word_block const &s) {
+    return word_block{detail::last_column<3>(detail::sbox_inv, s, 0),
+                      detail::last_column<3>(detail::sbox_inv, s, 1),
+                      detail::last_column<3>(detail::sbox_inv, s, 2),
+                      detail::last_column<3>(detail::sbox_inv, s, 3)};
+  }
+};
+
+// Aes on 32-bit words with t-tables, same results as aes_cipher (the
+// decomposed reference) at a fraction of the cost
+template <std::size_t Unroll = 9> class basic_ttable_aes_cipher {
+  template <typename F, typename R>
+  using rounds_pipe = pipet::pipe<
+      key_filter<0, keyed_block>,
+      pipet::repeat<pipet::round_pipe<keyed_filter<F, keyed_block>,
+                                      round_key_filter<keyed_block>>,
+                    9, Unroll>,
+      keyed_filter<R, keyed_block>, key_filter<10, keyed_block>>;
+
+  using cipher_pipe =
+      rounds_pipe<ttable_round_filter, ttable_last_round_filter>;
+  using decipher_pipe =
+      rounds_pipe<ttable_inv_round_filter, ttable_inv_last_round_filter>;
+
+  exp_key<10> const m_k;
+
+public:
+  constexpr basic_ttable_aes_cipher(serial_key const &k) : m_k{k} {}
+
+  constexpr auto cipher(state s) const {
+    return detail::unpack_block(
+        cipher_pipe::process(keyed_block{detail::pack_block(s),
+                                         m_k.words.data()})
+            .s);
   }
 
   constexpr auto decipher(state s) const {
-    s = last_round_pipe::reverse(inject_key(s, m_k.get_at(10)));
+    return detail::unpack_block(
+        decipher_pipe::process(keyed_block{detail::pack_block(s),
+                                           m_k.dec_words.data()})
+            .s);
+  }
+};
+
+using ttable_aes_cipher = basic_ttable_aes_cipher<>;
+
+namespace detail {
+// bitsliced aes details: blocks are ciphered in place as 16 contiguous bytes
+
+static_assert(sizeof(state) == 16 && std::is_trivially_copyable_v<state>,
+              "[-][aes] state is not a 16 bytes block");
+
+inline bitslice::schedule bitsliced_schedule(key const *keys) {
+  std::array<bitslice::block_bytes, 11> bytes{};
+  for (std::size_t r = 0; r < bytes.size(); ++r) {
+    bytes[r] = serialize_key(keys[r].c0, keys[r].c1, keys[r].c2, keys[r].c3);
+  }
+  return bitslice::make_schedule(bytes);
+}
+
+template <bool Encrypt>
+void bitsliced_blocks(bitslice::schedule const &sk, state const *in,
+                      state *out, std::size_t n) {
+  auto const src = reinterpret_cast<uint8_t const *>(in);
+  auto const dst = reinterpret_cast<uint8_t *>(out);
+  if constexpr (Encrypt) {
+    bitslice::encrypt(sk, src, dst, n);
+  } else {
+    bitslice::decrypt(sk, src, dst, n);
+  }
+}
+
+// runs of keyed states sharing their round keys, gathered by chunks
+template <bool Encrypt>
+void bitsliced_batch(pipet::helpers::span<keyed_state const> in,
+                     pipet::helpers::span<keyed_state> out) {
+  constexpr std::size_t chunk_size = 64;
+  std::array<state, chunk_size> chunk;
+
+  for (std::size_t i = 0; i < in.size();) {
+    auto const keys = in[i].keys;
+    auto const sk = bitsliced_schedule(keys);
+
+    while (i < in.size() && in[i].keys == keys) {
+      std::size_t n = 0;
+      for (; n < chunk_size && i + n < in.size() && in[i + n].keys == keys;
+           ++n) {
+        chunk[n] = in[i + n].s;
+      }
+      bitsliced_blocks<Encrypt>(sk, chunk.data(), chunk.data(), n);
+      for (std::size_t j = 0; j < n; ++j) {
+        out[i + j] = keyed_state{chunk[j], keys};
+      }
+      i += n;
+    }
+  }
+}
+} // namespace detail
+
+// Bitsliced aes filter (whole cipher, constant time, runtime only), keyed
+// states carry the encryption round keys in both directions and the batch
+// routines cipher 8 (sse2) or 16 (avx2) blocks at once
+struct bitsliced_aes_filter {
+  static keyed_state process(keyed_state const &ks) {
+    keyed_state res{};
+    process_batch({&ks, 1}, {&res, 1});
+    return res;
+  }
+
+  static keyed_state reverse(keyed_state const &ks) {
+    keyed_state res{};
+    reverse_batch({&ks, 1}, {&res, 1});
+    return res;
+  }
+
+  static void process_batch(pipet::helpers::span<keyed_state const> in,
+                            pipet::helpers::span<keyed_state> out) {
+    detail::bitsliced_batch<true>(in, out);
+  }
+
+  static void reverse_batch(pipet::helpers::span<keyed_state const> in,
+                            pipet::helpers::span<keyed_state> out) {
+    detail::bitsliced_batch<false>(in, out);
+  }
+};
+
+// Bitsliced aes on buffers of blocks (same results as aes_cipher)
+class bitsliced_aes_cipher {
+  bitslice::schedule const m_sk;
+
+public:
+  bitsliced_aes_cipher(serial_key const &k)
+      : m_sk{detail::bitsliced_schedule(exp_key<10>{k}.keys.data())} {}
+
+  state cipher(state s) const {
+    cipher_blocks({&s, 1}, {&s, 1});
+    return s;
+  }
+
+  state decipher(state s) const {
+    decipher_blocks({&s, 1}, {&s, 1});
+    return s;
+  }
+
+  void cipher_blocks(pipet::helpers::span<state const> in,
+                     pipet::helpers::span<state> out) const {
+    detail::bitsliced_blocks<true>(m_sk, in.data(), out.data(), in.size());
+  }
+
+  void decipher_blocks(pipet::helpers::span<state const> in,
+                       pipet::helpers::span<state> out) const {
+    detail::bitsliced_blocks<false>(m_sk, in.data(), out.data(), in.size());
+  }
+};
 
-    for (auto i = 9; i >= 1; --i) {
-      s = round_pipe::reverse(inject_key(s, m_k.get_at(i)));
+// Aes with the aes-ni instructions when the cpu supports them (cipher_blocks
+// interleaves 8 blocks), the pipe otherwise and in constant evaluation.
+// cipher and decipher tell runtime calls apart with
+// __builtin_is_constant_evaluated: compilers without it (g++ < 9, clang < 9)
+// always run the pipe there, the non constexpr cipher_blocks and
+// decipher_blocks (and the ecb deciphering, ctr and cbc entry points built
+// on them) select aes-ni with every compiler
+class aes_cipher : public basic_aes_cipher<> {
+  static uint8_t const *bytes(state const *s) {
+    return reinterpret_cast<uint8_t const *>(s);
+  }
+
+  static uint8_t *bytes(state *s) { return reinterpret_cast<uint8_t *>(s); }
+
+public:
+  using basic_aes_cipher::basic_aes_cipher;
+
+  constexpr state cipher(state s) const {
+    if (!pipet::helpers::is_constant_evaluated() && aesni::available()) {
+      cipher_blocks({&s, 1}, {&s, 1});
+      return s;
+    }
+    return basic_aes_cipher::cipher(s);
+  }
+
+  constexpr state decipher(state s) const {
+    if (!pipet::helpers::is_constant_evaluated() && aesni::available()) {
+      decipher_blocks({&s, 1}, {&s, 1});
+      return s;
+    }
+    return basic_aes_cipher::decipher(s);
+  }
+
+  void cipher_blocks(pipet::helpers::span<state const> in,
+                     pipet::helpers::span<state> out) const {
+    if (aesni::available()) {
+      aesni::encrypt(bytes(m_k.keys.data()), bytes(in.data()),
+                     bytes(out.data()), in.size());
+    } else {
+      for (std::size_t i = 0; i < in.size(); ++i) {
+        out[i] = basic_aes_cipher::cipher(in[i]);
+      }
     }
+  }
 
-    return inject_key(s, m_k.get_at(0));
+  void decipher_blocks(pipet::helpers::span<state const> in,
+                       pipet::helpers::span<state> out) const {
+    if (aesni::available()) {
+      aesni::decrypt(bytes(m_k.dec_keys.data()), bytes(in.data()),
+                     bytes(out.data()), in.size());
+    } else {
+      for (std::size_t i = 0; i < in.size(); ++i) {
+        out[i] = basic_aes_cipher::decipher(in[i]);
+      }
+    }
   }
 };
 
+namespace detail {
+// runtime ecb: aes-ni when supported, bitsliced (constant time) otherwise
+template <bool Encrypt, typename Cipher>
+void ecb_blocks(Cipher const &c, pipet::helpers::span<state const> in,
+                pipet::helpers::span<state> out) {
+  if constexpr (Encrypt) {
+    c.cipher_blocks(in, out);
+  } else {
+    c.decipher_blocks(in, out);
+  }
+}
+
+// f called with the multi-block cipher selected at runtime
+template <typename F> void with_runtime_cipher(serial_key const &k, F &&f) {
+  if (aesni::available()) {
+    f(aes_cipher{k});
+  } else {
+    f(bitsliced_aes_cipher{k});
+  }
+}
+
+template <bool Encrypt>
+void ecb_blocks(serial_key const &k, pipet::helpers::span<state const> in,
+                pipet::helpers::span<state> out) {
+  with_runtime_cipher(
+      k, [&](auto const &c) { ecb_blocks<Encrypt>(c, in, out); });
+}
+} // namespace detail
+
 // Just for fun, a variable block size aes entry point (currently just using
 // ecb that is known to be weak)
 template <size_t N>
@@ -333,10 +786,17 @@ constexpr auto aes_ecb_cipher(serial_key const &k,
   }
 
   std::array<state, sz / 16> ciphered{};
-  auto aes_encryptor = aes_cipher{k};
   for (unsigned int i = 0; i < sz; i += 16) {
-    ciphered[i / 16] =
-        aes_encryptor.cipher(detail::parse_state(&padded_plain[i]));
+    ciphered[i / 16] = detail::parse_state(&padded_plain[i]);
+  }
+
+  if (pipet::helpers::is_constant_evaluated()) {
+    auto aes_encryptor = ttable_aes_cipher{k};
+    for (auto &s : ciphered) {
+      s = aes_encryptor.cipher(s);
+    }
+  } else {
+    detail::ecb_blocks<true>(k, ciphered, ciphered);
   }
 
   return ciphered;
@@ -345,12 +805,207 @@ constexpr auto aes_ecb_cipher(serial_key const &k,
 template <typename Container, std::size_t N>
 auto aes_ecb_decipher(serial_key const &k, std::array<state, N> const &cipher) {
   Container padded_plain{};
-  auto aes_encryptor = aes_cipher{k};
+  std::array<state, N> plain{};
+  detail::ecb_blocks<false>(k, cipher, plain);
 
-  for (unsigned i = 0; i < N; ++i) {
-    detail::extend(padded_plain, aes_encryptor.decipher(cipher[i]));
+  for (auto const &s : plain) {
+    detail::extend(padded_plain, s);
   }
 
   return detail::remove_pad(padded_plain);
 }
+
+namespace detail {
+// bulk modes details: buffers are split in chunks of blocks run on a pool,
+// a chunk being processed by batches of blocks held on the stack
+
+constexpr std::size_t chunk_blocks = 4096;
+constexpr std::size_t batch_blocks = 64;
+
+inline state load_state(uint8_t const *src) {
+  state res;
+  std::memcpy(&res, src, sizeof(state));
+  return res;
+}
+
+inline void xor_bytes(uint8_t const *a, uint8_t const *b, uint8_t *out,
+                      std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = static_cast<uint8_t>(a[i] ^ b[i]);
+  }
+}
+
+// f(first, count) for every chunk of n blocks, on the calling thread when
+// there is a single chunk
+template <typename F>
+void parallel_chunks(pipet::helpers::thread_pool &pool, std::size_t n,
+                     F const &f) {
+  if (n <= chunk_blocks) {
+    f(std::size_t{0}, n);
+    return;
+  }
+
+  pipet::helpers::task_group group{pool};
+  for (std::size_t first = 0; first < n; first += chunk_blocks) {
+    group.run([&f, first, n] {
+      f(first, std::min(chunk_blocks, n - first));
+    });
+  }
+  group.wait();
+}
+
+// counter block as a 128-bit big endian integer (high and low halves)
+using counter128 = std::array<uint64_t, 2>;
+
+inline counter128 load_counter(serial_state const &ctr) {
+  counter128 res{};
+  for (std::size_t b = 0; b < 8; ++b) {
+    res[0] = (res[0] << 8) | ctr[b];
+    res[1] = (res[1] << 8) | ctr[8 + b];
+  }
+  return res;
+}
+
+inline void store_be64(uint64_t v, uint8_t *dst) {
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  v = __builtin_bswap64(v);
+  std::memcpy(dst, &v, sizeof(v));
+#else
+  for (std::size_t b = 0; b < 8; ++b) {
+    dst[b] = static_cast<uint8_t>(v >> (56 - 8 * b));
+  }
+#endif
+}
+
+// n counter blocks from block i (initial counter + i)
+inline void counter_blocks(counter128 const &ctr, std::size_t i,
+                           uint8_t *dst, std::size_t n) {
+  auto const lo = ctr[1] + i;
+  auto const hi = ctr[0] + (lo < ctr[1]);
+  for (std::size_t j = 0; j < n; ++j) {
+    store_be64(hi + (lo + j < lo), dst + 16 * j);
+    store_be64(lo + j, dst + 16 * j + 8);
+  }
+}
+
+// bytes [16 * first, 16 * first + size) of a ctr stream
+template <typename Cipher>
+void ctr_chunk(Cipher const &c, counter128 const &ctr, std::size_t first,
+               uint8_t const *in, uint8_t *out, std::size_t size) {
+  std::array<state, batch_blocks> stream;
+  for (std::size_t done = 0; done < size;) {
+    auto const bytes = std::min(16 * batch_blocks, size - done);
+    auto const n = (bytes + 15) / 16;
+    counter_blocks(ctr, first + done / 16,
+                   reinterpret_cast<uint8_t *>(stream.data()), n);
+    c.cipher_blocks({stream.data(), n}, {stream.data(), n});
+    xor_bytes(in + done, reinterpret_cast<uint8_t const *>(stream.data()),
+              out + done, bytes);
+    done += bytes;
+  }
+}
+
+// blocks [first, first + count) of a cbc deciphering, block i chained with
+// ciphered block i - 1 (iv for the first block)
+template <typename Cipher>
+void cbc_decipher_chunk(Cipher const &c, serial_state const &iv,
+                        std::size_t first, std::size_t count,
+                        uint8_t const *in, uint8_t *out) {
+  std::array<state, batch_blocks> plain;
+  for (std::size_t done = 0; done < count;) {
+    auto const n = std::min(batch_blocks, count - done);
+    auto const block = first + done;
+    for (std::size_t j = 0; j < n; ++j) {
+      plain[j] = load_state(in + 16 * (block + j));
+    }
+    c.decipher_blocks({plain.data(), n}, {plain.data(), n});
+
+    auto const src = reinterpret_cast<uint8_t const *>(plain.data());
+    xor_bytes(src, block ? in + 16 * (block - 1) : iv.data(),
+              out + 16 * block, 16);
+    xor_bytes(src + 16, in + 16 * block, out + 16 * (block + 1),
+              16 * (n - 1));
+    done += n;
+  }
+}
+} // namespace detail
+
+// Bulk runtime modes (aes-ni or bitsliced blocks), chunks of 64 KiB ciphered
+// in parallel on a pool, output written to a caller buffer (not overlapping
+// the input)
+
+// ctr mode (ciphering and deciphering are the same), in of any size, the
+// counter block is incremented as a 128-bit big endian integer
+inline void aes_ctr(serial_key const &k, serial_state const &counter,
+                    pipet::helpers::span<uint8_t const> in,
+                    pipet::helpers::span<uint8_t> out,
+                    pipet::helpers::thread_pool &pool =
+                        pipet::helpers::thread_pool::shared()) {
+  assert(out.size() >= in.size() && "[-][aes] output buffer too small");
+
+  auto const ctr = detail::load_counter(counter);
+  detail::with_runtime_cipher(k, [&](auto const &c) {
+    detail::parallel_chunks(
+        pool, (in.size() + 15) / 16, [&](std::size_t first, std::size_t n) {
+          auto const offset = 16 * first;
+          detail::ctr_chunk(c, ctr, first, in.data() + offset,
+                            out.data() + offset,
+                            std::min(16 * n, in.size() - offset));
+        });
+  });
+}
+
+namespace detail {
+// cipher_block: single block cipher (state -> state)
+template <typename Fn>
+void cbc_cipher_blocks(Fn const &cipher_block, serial_state const &iv,
+                       uint8_t const *in, uint8_t *out, std::size_t size) {
+  auto chain = parse_state(iv.data());
+  for (std::size_t i = 0; i < size; i += 16) {
+    chain = cipher_block(load_state(in + i) ^ chain);
+    std::memcpy(out + i, &chain, sizeof(state));
+  }
+}
+} // namespace detail
+
+// cbc mode ciphering (serial by nature, one block at a time: aes-ni or
+// t-tables, a bitsliced batch would be mostly padding), in of a multiple of
+// 16 bytes (no padding)
+inline void aes_cbc_cipher(serial_key const &k, serial_state const &iv,
+                           pipet::helpers::span<uint8_t const> in,
+                           pipet::helpers::span<uint8_t> out) {
+  assert(in.size() % 16 == 0 && "[-][aes] partial cbc block");
+  assert(out.size() >= in.size() && "[-][aes] output buffer too small");
+
+  if (aesni::available()) {
+    auto const c = aes_cipher{k};
+    detail::cbc_cipher_blocks(
+        [&c](state s) {
+          c.cipher_blocks({&s, 1}, {&s, 1});
+          return s;
+        },
+        iv, in.data(), out.data(), in.size());
+  } else {
+    auto const c = ttable_aes_cipher{k};
+    detail::cbc_cipher_blocks([&c](state s) { return c.cipher(s); }, iv,
+                              in.data(), out.data(), in.size());
+  }
+}
+
+// cbc mode deciphering, blocks deciphered in parallel
+inline void aes_cbc_decipher(serial_key const &k, serial_state const &iv,
+                             pipet::helpers::span<uint8_t const> in,
+                             pipet::helpers::span<uint8_t> out,
+                             pipet::helpers::thread_pool &pool =
+                                 pipet::helpers::thread_pool::shared()) {
+  assert(in.size() % 16 == 0 && "[-][aes] partial cbc block");
+  assert(out.size() >= in.size() && "[-][aes] output buffer too small");
+
+  detail::with_runtime_cipher(k, [&](auto const &c) {
+    detail::parallel_chunks(
+        pool, in.size() / 16, [&](std::size_t first, std::size_t n) {
+          detail::cbc_decipher_chunk(c, iv, first, n, in.data(), out.data());
+        });
+  });
+}
 } // namespace aes
\ No newline at end of file
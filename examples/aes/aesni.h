@@ -0,0 +1,116 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pipet/helpers/cpu.h"
+
+//
+// Aes 128 with the aes-ni instructions (selected at runtime)
+//
+// A round is one aesenc (aesdec) instruction, its latency is hidden by
+// interleaving the rounds of 8 independent blocks (then 4, then 1 for the
+// tail). Decryption uses the round keys of the equivalent inverse cipher,
+// InvMixColumns applied to the inner round keys.
+//
+
+#if PIPET_X86_SIMD && (defined(__GNUC__) || defined(__clang__))
+#define AES_AESNI 1
+#define AES_AESNI_INLINE inline __attribute__((always_inline))
+#else
+#define AES_AESNI 0
+#define AES_AESNI_INLINE inline
+#endif
+
+namespace aes::aesni {
+// cpu support (always false when the kernel is not compiled)
+inline bool available() {
+#if AES_AESNI
+  return pipet::helpers::cpu().aes;
+#else
+  return false;
+#endif
+}
+
+#if AES_AESNI
+namespace detail {
+// B blocks, every round applied to all blocks before the next one
+template <std::size_t B, bool Encrypt>
+PIPET_TARGET("aes")
+AES_AESNI_INLINE void crypt(__m128i const (&rk)[11], uint8_t const *in,
+                            uint8_t *out) {
+  __m128i b[B];
+  for (std::size_t j = 0; j < B; ++j) {
+    b[j] = _mm_xor_si128(
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + 16 * j)),
+        rk[0]);
+  }
+  for (std::size_t r = 1; r < 10; ++r) {
+    for (std::size_t j = 0; j < B; ++j) {
+      b[j] = Encrypt ? _mm_aesenc_si128(b[j], rk[r])
+                     : _mm_aesdec_si128(b[j], rk[r]);
+    }
+  }
+  for (std::size_t j = 0; j < B; ++j) {
+    b[j] = Encrypt ? _mm_aesenclast_si128(b[j], rk[10])
+                   : _mm_aesdeclast_si128(b[j], rk[10]);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16 * j), b[j]);
+  }
+}
+
+template <bool Encrypt>
+PIPET_TARGET("aes")
+void run(uint8_t const *keys, uint8_t const *in, uint8_t *out,
+         std::size_t n) {
+  __m128i rk[11];
+  for (std::size_t r = 0; r < 11; ++r) {
+    rk[r] = _mm_loadu_si128(reinterpret_cast<__m128i const *>(keys + 16 * r));
+  }
+
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    crypt<8, Encrypt>(rk, in + 16 * i, out + 16 * i);
+  }
+  if (i + 4 <= n) {
+    crypt<4, Encrypt>(rk, in + 16 * i, out + 16 * i);
+    i += 4;
+  }
+  for (; i < n; ++i) {
+    crypt<1, Encrypt>(rk, in + 16 * i, out + 16 * i);
+  }
+}
+} // namespace detail
+
+// n consecutive 16-byte blocks (in and out may alias), keys: the 11 round
+// keys (176 bytes) in order of use, only callable when available()
+inline void encrypt(uint8_t const *keys, uint8_t const *in, uint8_t *out,
+                    std::size_t n) {
+  detail::run<true>(keys, in, out, n);
+}
+
+inline void decrypt(uint8_t const *dec_keys, uint8_t const *in, uint8_t *out,
+                    std::size_t n) {
+  detail::run<false>(dec_keys, in, out, n);
+}
+#else
+inline void encrypt(uint8_t const *, uint8_t const *, uint8_t *,
+                    std::size_t) {}
+
+inline void decrypt(uint8_t const *, uint8_t const *, uint8_t *,
+                    std::size_t) {}
+#endif
+} // namespace aes::aesni
\ No newline at end of file
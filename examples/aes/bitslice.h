@@ -0,0 +1,525 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "pipet/helpers/cpu.h"
+
+//
+// Constant-time bitsliced aes 128 (no table, no secret dependent branch)
+//
+// 8 registers hold one bit of every state byte of several blocks, 4 blocks
+// per 64-bit lane: the same code runs 4 blocks on a uint64_t, 8 blocks on a
+// sse2 register and 16 blocks on an avx2 register (selected at runtime).
+// The S-box is the Boyar-Peralta boolean circuit.
+//
+
+#if PIPET_X86_SIMD && (defined(__GNUC__) || defined(__clang__))
+#define AES_BITSLICE_VECTORS 1
+#define AES_BITSLICE_INLINE inline __attribute__((always_inline))
+#else
+#define AES_BITSLICE_VECTORS 0
+#define AES_BITSLICE_INLINE inline
+#endif
+
+namespace aes::bitslice {
+using block_bytes = std::array<uint8_t, 16>;
+
+// round keys replicated over the 4 blocks of a lane
+struct schedule {
+  std::array<std::array<uint64_t, 8>, 11> rk;
+};
+
+namespace detail {
+#if AES_BITSLICE_VECTORS
+typedef uint64_t u64x2 __attribute__((vector_size(16)));
+typedef uint64_t u64x4 __attribute__((vector_size(32)));
+#endif
+
+template <typename V> constexpr std::size_t lanes_v = sizeof(V) / 8;
+
+template <typename V> constexpr std::size_t batch_v = 4 * lanes_v<V>;
+
+inline uint32_t dec32le(uint8_t const *src) {
+  return uint32_t{src[0]} | (uint32_t{src[1]} << 8) |
+         (uint32_t{src[2]} << 16) | (uint32_t{src[3]} << 24);
+}
+
+inline void enc32le(uint8_t *dst, uint32_t x) {
+  dst[0] = static_cast<uint8_t>(x);
+  dst[1] = static_cast<uint8_t>(x >> 8);
+  dst[2] = static_cast<uint8_t>(x >> 16);
+  dst[3] = static_cast<uint8_t>(x >> 24);
+}
+
+// bytes of a block spread over two lanes (even/odd bytes of each word)
+AES_BITSLICE_INLINE void interleave_in(uint64_t &q0, uint64_t &q1,
+                                       uint8_t const *src) {
+  uint64_t x[4];
+  for (int i = 0; i < 4; ++i) {
+    x[i] = dec32le(src + 4 * i);
+    x[i] |= x[i] << 16;
+    x[i] &= 0x0000FFFF0000FFFFull;
+    x[i] |= x[i] << 8;
+    x[i] &= 0x00FF00FF00FF00FFull;
+  }
+  q0 = x[0] | (x[2] << 8);
+  q1 = x[1] | (x[3] << 8);
+}
+
+AES_BITSLICE_INLINE void interleave_out(uint8_t *dst, uint64_t q0,
+                                        uint64_t q1) {
+  uint64_t x[4] = {q0 & 0x00FF00FF00FF00FFull, q1 & 0x00FF00FF00FF00FFull,
+                   (q0 >> 8) & 0x00FF00FF00FF00FFull,
+                   (q1 >> 8) & 0x00FF00FF00FF00FFull};
+  for (int i = 0; i < 4; ++i) {
+    x[i] |= x[i] >> 8;
+    x[i] &= 0x0000FFFF0000FFFFull;
+    enc32le(dst + 4 * i,
+            static_cast<uint32_t>(x[i]) | static_cast<uint32_t>(x[i] >> 16));
+  }
+}
+
+template <uint64_t Lo, uint64_t Hi, int S, typename V>
+AES_BITSLICE_INLINE void swap_bits(V &x, V &y) {
+  V const a = x;
+  V const b = y;
+  x = (a & Lo) | ((b & Lo) << S);
+  y = ((a & Hi) >> S) | (b & Hi);
+}
+
+// transposition between interleaved bytes and bit planes (an involution)
+template <typename V> AES_BITSLICE_INLINE void ortho(V *q) {
+  constexpr uint64_t l2 = 0x5555555555555555ull, h2 = ~l2;
+  constexpr uint64_t l4 = 0x3333333333333333ull, h4 = ~l4;
+  constexpr uint64_t l8 = 0x0F0F0F0F0F0F0F0Full, h8 = ~l8;
+
+  for (int i = 0; i < 8; i += 2) {
+    swap_bits<l2, h2, 1>(q[i], q[i + 1]);
+  }
+  for (int i : {0, 1, 4, 5}) {
+    swap_bits<l4, h4, 2>(q[i], q[i + 2]);
+  }
+  for (int i = 0; i < 4; ++i) {
+    swap_bits<l8, h8, 4>(q[i], q[i + 4]);
+  }
+}
+
+template <typename V> AES_BITSLICE_INLINE void sbox(V *q) {
+  // top linear transformation
+  V const x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4];
+  V const x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+  V const y14 = x3 ^ x5;
+  V const y13 = x0 ^ x6;
+  V const y9 = x0 ^ x3;
+  V const y8 = x0 ^ x5;
+  V const t0 = x1 ^ x2;
+  V const y1 = t0 ^ x7;
+  V const y4 = y1 ^ x3;
+  V const y12 = y13 ^ y14;
+  V const y2 = y1 ^ x0;
+  V const y5 = y1 ^ x6;
+  V const y3 = y5 ^ y8;
+  V const t1 = x4 ^ y12;
+  V const y15 = t1 ^ x5;
+  V const y20 = t1 ^ x1;
+  V const y6 = y15 ^ x7;
+  V const y10 = y15 ^ t0;
+  V const y11 = y20 ^ y9;
+  V const y7 = x7 ^ y11;
+  V const y17 = y10 ^ y11;
+  V const y19 = y10 ^ y8;
+  V const y16 = t0 ^ y11;
+  V const y21 = y13 ^ y16;
+  V const y18 = x0 ^ y16;
+
+  // non-linear section
+  V const t2 = y12 & y15;
+  V const t3 = y3 & y6;
+  V const t4 = t3 ^ t2;
+  V const t5 = y4 & x7;
+  V const t6 = t5 ^ t2;
+  V const t7 = y13 & y16;
+  V const t8 = y5 & y1;
+  V const t9 = t8 ^ t7;
+  V const t10 = y2 & y7;
+  V const t11 = t10 ^ t7;
+  V const t12 = y9 & y11;
+  V const t13 = y14 & y17;
+  V const t14 = t13 ^ t12;
+  V const t15 = y8 & y10;
+  V const t16 = t15 ^ t12;
+  V const t17 = t4 ^ t14;
+  V const t18 = t6 ^ t16;
+  V const t19 = t9 ^ t14;
+  V const t20 = t11 ^ t16;
+  V const t21 = t17 ^ y20;
+  V const t22 = t18 ^ y19;
+  V const t23 = t19 ^ y21;
+  V const t24 = t20 ^ y18;
+
+  V const t25 = t21 ^ t22;
+  V const t26 = t21 & t23;
+  V const t27 = t24 ^ t26;
+  V const t28 = t25 & t27;
+  V const t29 = t28 ^ t22;
+  V const t30 = t23 ^ t24;
+  V const t31 = t22 ^ t26;
+  V const t32 = t31 & t30;
+  V const t33 = t32 ^ t24;
+  V const t34 = t23 ^ t33;
+  V const t35 = t27 ^ t33;
+  V const t36 = t24 & t35;
+  V const t37 = t36 ^ t34;
+  V const t38 = t27 ^ t36;
+  V const t39 = t29 & t38;
+  V const t40 = t25 ^ t39;
+
+  V const t41 = t40 ^ t37;
+  V const t42 = t29 ^ t33;
+  V const t43 = t29 ^ t40;
+  V const t44 = t33 ^ t37;
+  V const t45 = t42 ^ t41;
+  V const z0 = t44 & y15;
+  V const z1 = t37 & y6;
+  V const z2 = t33 & x7;
+  V const z3 = t43 & y16;
+  V const z4 = t40 & y1;
+  V const z5 = t29 & y7;
+  V const z6 = t42 & y11;
+  V const z7 = t45 & y17;
+  V const z8 = t41 & y10;
+  V const z9 = t44 & y12;
+  V const z10 = t37 & y3;
+  V const z11 = t33 & y4;
+  V const z12 = t43 & y13;
+  V const z13 = t40 & y5;
+  V const z14 = t29 & y2;
+  V const z15 = t42 & y9;
+  V const z16 = t45 & y14;
+  V const z17 = t41 & y8;
+
+  // bottom linear transformation
+  V const t46 = z15 ^ z16;
+  V const t47 = z10 ^ z11;
+  V const t48 = z5 ^ z13;
+  V const t49 = z9 ^ z10;
+  V const t50 = z2 ^ z12;
+  V const t51 = z2 ^ z5;
+  V const t52 = z7 ^ z8;
+  V const t53 = z0 ^ z3;
+  V const t54 = z6 ^ z7;
+  V const t55 = z16 ^ z17;
+  V const t56 = z12 ^ t48;
+  V const t57 = t50 ^ t53;
+  V const t58 = z4 ^ t46;
+  V const t59 = z3 ^ t54;
+  V const t60 = t46 ^ t57;
+  V const t61 = z14 ^ t57;
+  V const t62 = t52 ^ t58;
+  V const t63 = t49 ^ t58;
+  V const t64 = z4 ^ t59;
+  V const t65 = t61 ^ t62;
+  V const t66 = z1 ^ t63;
+  V const s0 = t59 ^ t63;
+  V const s6 = t56 ^ ~t62;
+  V const s7 = t48 ^ ~t60;
+  V const t67 = t64 ^ t65;
+  V const s3 = t53 ^ t66;
+  V const s4 = t51 ^ t66;
+  V const s5 = t47 ^ t65;
+  V const s1 = t64 ^ ~s3;
+  V const s2 = t55 ^ ~t67;
+
+  q[7] = s0;
+  q[6] = s1;
+  q[5] = s2;
+  q[4] = s3;
+  q[3] = s4;
+  q[2] = s5;
+  q[1] = s6;
+  q[0] = s7;
+}
+
+// inverse of the S-box affine map (on both sides of the S-box)
+template <typename V> AES_BITSLICE_INLINE void inv_affine(V *q) {
+  V const q0 = ~q[0], q1 = ~q[1], q2 = q[2], q3 = q[3];
+  V const q4 = q[4], q5 = ~q[5], q6 = ~q[6], q7 = q[7];
+  q[7] = q1 ^ q4 ^ q6;
+  q[6] = q0 ^ q3 ^ q5;
+  q[5] = q7 ^ q2 ^ q4;
+  q[4] = q6 ^ q1 ^ q3;
+  q[3] = q5 ^ q0 ^ q2;
+  q[2] = q4 ^ q7 ^ q1;
+  q[1] = q3 ^ q6 ^ q0;
+  q[0] = q2 ^ q5 ^ q7;
+}
+
+template <typename V> AES_BITSLICE_INLINE void inv_sbox(V *q) {
+  inv_affine(q);
+  sbox(q);
+  inv_affine(q);
+}
+
+template <typename V> AES_BITSLICE_INLINE void shift_rows(V *q) {
+  for (int i = 0; i < 8; ++i) {
+    V const x = q[i];
+    q[i] = (x & 0x000000000000FFFFull) | ((x & 0x00000000FFF00000ull) >> 4) |
+           ((x & 0x00000000000F0000ull) << 12) |
+           ((x & 0x0000FF0000000000ull) >> 8) |
+           ((x & 0x000000FF00000000ull) << 8) |
+           ((x & 0xF000000000000000ull) >> 12) |
+           ((x & 0x0FFF000000000000ull) << 4);
+  }
+}
+
+template <typename V> AES_BITSLICE_INLINE void inv_shift_rows(V *q) {
+  for (int i = 0; i < 8; ++i) {
+    V const x = q[i];
+    q[i] = (x & 0x000000000000FFFFull) | ((x & 0x000000000FFF0000ull) << 4) |
+           ((x & 0x00000000F0000000ull) >> 12) |
+           ((x & 0x000000FF00000000ull) << 8) |
+           ((x & 0x0000FF0000000000ull) >> 8) |
+           ((x & 0x000F000000000000ull) << 12) |
+           ((x & 0xFFF0000000000000ull) >> 4);
+  }
+}
+
+// rows of a column are 16 bits apart in a lane (vectors are passed by
+// reference, an avx2 vector passed by value to a function compiled without
+// avx2 has another abi)
+template <int N, typename V> AES_BITSLICE_INLINE void rotr(V &x) {
+  x = (x >> N) | (x << (64 - N));
+}
+
+template <int N, typename V>
+AES_BITSLICE_INLINE void rotr_all(V (&x)[8]) {
+  for (int i = 0; i < 8; ++i) {
+    rotr<N>(x[i]);
+  }
+}
+
+template <typename V> AES_BITSLICE_INLINE void mix_columns(V *q) {
+  V const q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+  V const q4 = q[4], q5 = q[5], q6 = q[6], q7 = q[7];
+  V r[8] = {q0, q1, q2, q3, q4, q5, q6, q7};
+  rotr_all<16>(r);
+
+  V t[8] = {q0 ^ r[0], q1 ^ r[1], q2 ^ r[2], q3 ^ r[3],
+            q4 ^ r[4], q5 ^ r[5], q6 ^ r[6], q7 ^ r[7]};
+  rotr_all<32>(t);
+
+  q[0] = q7 ^ r[7] ^ r[0] ^ t[0];
+  q[1] = q0 ^ r[0] ^ q7 ^ r[7] ^ r[1] ^ t[1];
+  q[2] = q1 ^ r[1] ^ r[2] ^ t[2];
+  q[3] = q2 ^ r[2] ^ q7 ^ r[7] ^ r[3] ^ t[3];
+  q[4] = q3 ^ r[3] ^ q7 ^ r[7] ^ r[4] ^ t[4];
+  q[5] = q4 ^ r[4] ^ r[5] ^ t[5];
+  q[6] = q5 ^ r[5] ^ r[6] ^ t[6];
+  q[7] = q6 ^ r[6] ^ r[7] ^ t[7];
+}
+
+template <typename V> AES_BITSLICE_INLINE void inv_mix_columns(V *q) {
+  V const q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+  V const q4 = q[4], q5 = q[5], q6 = q[6], q7 = q[7];
+  V r[8] = {q0, q1, q2, q3, q4, q5, q6, q7};
+  rotr_all<16>(r);
+  V const r0 = r[0], r1 = r[1], r2 = r[2], r3 = r[3];
+  V const r4 = r[4], r5 = r[5], r6 = r[6], r7 = r[7];
+
+  V t[8] = {q0 ^ q5 ^ q6 ^ r0 ^ r5,
+            q1 ^ q5 ^ q7 ^ r1 ^ r5 ^ r6,
+            q0 ^ q2 ^ q6 ^ r2 ^ r6 ^ r7,
+            q0 ^ q1 ^ q3 ^ q5 ^ q6 ^ q7 ^ r0 ^ r3 ^ r5 ^ r7,
+            q1 ^ q2 ^ q4 ^ q5 ^ q7 ^ r1 ^ r4 ^ r5 ^ r6,
+            q2 ^ q3 ^ q5 ^ q6 ^ r2 ^ r5 ^ r6 ^ r7,
+            q3 ^ q4 ^ q6 ^ q7 ^ r3 ^ r6 ^ r7,
+            q4 ^ q5 ^ q7 ^ r4 ^ r7};
+  rotr_all<32>(t);
+
+  q[0] = q5 ^ q6 ^ q7 ^ r0 ^ r5 ^ r7 ^ t[0];
+  q[1] = q0 ^ q5 ^ r0 ^ r1 ^ r5 ^ r6 ^ r7 ^ t[1];
+  q[2] = q0 ^ q1 ^ q6 ^ r1 ^ r2 ^ r6 ^ r7 ^ t[2];
+  q[3] = q0 ^ q1 ^ q2 ^ q5 ^ q6 ^ r0 ^ r2 ^ r3 ^ r5 ^ t[3];
+  q[4] = q1 ^ q2 ^ q3 ^ q5 ^ r1 ^ r3 ^ r4 ^ r5 ^ r6 ^ r7 ^ t[4];
+  q[5] = q2 ^ q3 ^ q4 ^ q6 ^ r2 ^ r4 ^ r5 ^ r6 ^ r7 ^ t[5];
+  q[6] = q3 ^ q4 ^ q5 ^ q7 ^ r3 ^ r5 ^ r6 ^ r7 ^ t[6];
+  q[7] = q4 ^ q5 ^ q6 ^ r4 ^ r6 ^ r7 ^ t[7];
+}
+
+template <typename V>
+AES_BITSLICE_INLINE void add_round_key(V *q,
+                                       std::array<uint64_t, 8> const &rk) {
+  for (int i = 0; i < 8; ++i) {
+    q[i] ^= rk[i];
+  }
+}
+
+template <typename V>
+AES_BITSLICE_INLINE void encrypt(schedule const &sk, V *q) {
+  add_round_key(q, sk.rk[0]);
+  for (std::size_t r = 1; r < 10; ++r) {
+    sbox(q);
+    shift_rows(q);
+    mix_columns(q);
+    add_round_key(q, sk.rk[r]);
+  }
+  sbox(q);
+  shift_rows(q);
+  add_round_key(q, sk.rk[10]);
+}
+
+template <typename V>
+AES_BITSLICE_INLINE void decrypt(schedule const &sk, V *q) {
+  add_round_key(q, sk.rk[10]);
+  for (std::size_t r = 9; r > 0; --r) {
+    inv_shift_rows(q);
+    inv_sbox(q);
+    add_round_key(q, sk.rk[r]);
+    inv_mix_columns(q);
+  }
+  inv_shift_rows(q);
+  inv_sbox(q);
+  add_round_key(q, sk.rk[0]);
+}
+
+// batch_v<V> blocks to bit planes and back
+template <typename V>
+AES_BITSLICE_INLINE void load(uint8_t const *src, V *q) {
+  constexpr std::size_t lanes = lanes_v<V>;
+  uint64_t planes[8][lanes];
+  for (std::size_t l = 0; l < lanes; ++l) {
+    for (std::size_t i = 0; i < 4; ++i) {
+      interleave_in(planes[i][l], planes[i + 4][l], src + 16 * (4 * l + i));
+    }
+  }
+  for (std::size_t i = 0; i < 8; ++i) {
+    std::memcpy(&q[i], planes[i], sizeof(V));
+  }
+  ortho(q);
+}
+
+template <typename V> AES_BITSLICE_INLINE void store(uint8_t *dst, V *q) {
+  constexpr std::size_t lanes = lanes_v<V>;
+  uint64_t planes[8][lanes];
+  ortho(q);
+  for (std::size_t i = 0; i < 8; ++i) {
+    std::memcpy(planes[i], &q[i], sizeof(V));
+  }
+  for (std::size_t l = 0; l < lanes; ++l) {
+    for (std::size_t i = 0; i < 4; ++i) {
+      interleave_out(dst + 16 * (4 * l + i), planes[i][l], planes[i + 4][l]);
+    }
+  }
+}
+
+template <typename V, bool Encrypt>
+AES_BITSLICE_INLINE void crypt(schedule const &sk, uint8_t const *src,
+                               uint8_t *dst) {
+  V q[8];
+  load(src, q);
+  if constexpr (Encrypt) {
+    encrypt(sk, q);
+  } else {
+    decrypt(sk, q);
+  }
+  store(dst, q);
+}
+
+// n blocks, the last partial batch is zero padded
+template <typename V, bool Encrypt>
+AES_BITSLICE_INLINE void run(schedule const &sk, uint8_t const *in,
+                             uint8_t *out, std::size_t n) {
+  constexpr std::size_t batch = batch_v<V>;
+
+  std::size_t i = 0;
+  for (; i + batch <= n; i += batch) {
+    crypt<V, Encrypt>(sk, in + 16 * i, out + 16 * i);
+  }
+  if (i < n) {
+    uint8_t buf[16 * batch] = {};
+    std::memcpy(buf, in + 16 * i, 16 * (n - i));
+    crypt<V, Encrypt>(sk, buf, buf);
+    std::memcpy(out + 16 * i, buf, 16 * (n - i));
+  }
+}
+
+#if AES_BITSLICE_VECTORS
+template <bool Encrypt>
+PIPET_TARGET("avx2")
+void run_avx2(schedule const &sk, uint8_t const *in, uint8_t *out,
+              std::size_t n) {
+  run<u64x4, Encrypt>(sk, in, out, n);
+}
+#endif
+
+template <bool Encrypt>
+void dispatch(schedule const &sk, uint8_t const *in, uint8_t *out,
+              std::size_t n) {
+#if AES_BITSLICE_VECTORS
+  if (pipet::helpers::cpu().avx2) {
+    run_avx2<Encrypt>(sk, in, out, n);
+  } else {
+    run<u64x2, Encrypt>(sk, in, out, n);
+  }
+#else
+  run<uint64_t, Encrypt>(sk, in, out, n);
+#endif
+}
+} // namespace detail
+
+// blocks processed per call by the selected implementation
+inline std::size_t batch_size() {
+#if AES_BITSLICE_VECTORS
+  return pipet::helpers::cpu().avx2 ? detail::batch_v<detail::u64x4>
+                                    : detail::batch_v<detail::u64x2>;
+#else
+  return detail::batch_v<uint64_t>;
+#endif
+}
+
+// bit planes of the 11 round keys
+inline schedule make_schedule(std::array<block_bytes, 11> const &keys) {
+  schedule res{};
+  for (std::size_t r = 0; r < keys.size(); ++r) {
+    uint8_t four[64];
+    for (std::size_t b = 0; b < 4; ++b) {
+      std::memcpy(four + 16 * b, keys[r].data(), 16);
+    }
+    uint64_t q[8];
+    detail::load(four, q);
+    for (std::size_t i = 0; i < 8; ++i) {
+      res.rk[r][i] = q[i];
+    }
+  }
+  return res;
+}
+
+// n consecutive 16-byte blocks (in and out may alias)
+inline void encrypt(schedule const &sk, uint8_t const *in, uint8_t *out,
+                    std::size_t n) {
+  detail::dispatch<true>(sk, in, out, n);
+}
+
+inline void decrypt(schedule const &sk, uint8_t const *in, uint8_t *out,
+                    std::size_t n) {
+  detail::dispatch<false>(sk, in, out, n);
+}
+} // namespace aes::bitslice
\ No newline at end of file
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 
@@ -28,6 +29,44 @@ constexpr auto cxstr2arr(Str const &str, std::index_sequence<Is...>) {
   return std::array<uint8_t, sizeof...(Is)>{static_cast<uint8_t>(str[Is])...};
 }
 
+// n chained blocks ciphered and deciphered by both implementations
+template <typename C1, typename C2>
+constexpr bool same_results(C1 const &c1, C2 const &c2, state s,
+                            std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    auto const res = c1.cipher(s);
+    auto const back = c1.decipher(s);
+    if (!equals(detail::pack_block(res), detail::pack_block(c2.cipher(s))) ||
+        !equals(detail::pack_block(back), detail::pack_block(c2.decipher(s)))) {
+      return false;
+    }
+    s = res;
+  }
+  return true;
+}
+
+// buffer ciphered and deciphered by cipher_blocks and decipher_blocks
+template <typename C1, typename C2, std::size_t N>
+bool same_blocks(C1 const &c1, C2 const &c2,
+                 std::array<state, N> const &blocks) {
+  std::array<state, N> res{};
+  c1.cipher_blocks(blocks, res);
+  for (std::size_t i = 0; i < N; ++i) {
+    if (!equals(detail::pack_block(res[i]),
+                detail::pack_block(c2.cipher(blocks[i])))) {
+      return false;
+    }
+  }
+
+  c1.decipher_blocks(res, res);
+  for (std::size_t i = 0; i < N; ++i) {
+    if (!equals(detail::pack_block(res[i]), detail::pack_block(blocks[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
 template <std::size_t N>
 constexpr auto aes_ecb_cipher_str(serial_key const &k, cxstring<N> const &str) {
   return aes_ecb_cipher(k, cxstr2arr(str, std::make_index_sequence<N>()));
@@ -50,6 +89,10 @@ int main() {
              serial_key{0xd0, 0x14, 0xf9, 0xa8, 0xc9, 0xee, 0x25, 0x89, 0xe1,
                         0x3f, 0x0c, 0xc8, 0xb6, 0x63, 0x0c, 0xa6}),
       "[aes] bad key computation");
+  static_assert(k.words[1][0] == 0xa0fafe17 && k.words[10][3] == 0xb6630ca6,
+                "[-][aes] bad key words");
+  static_assert(equals(k.dec_keys[0].c0, k.get_at(10).c0),
+                "[-][aes] bad decryption key schedule");
 
   constexpr auto s = state{{0x32, 0x43, 0xf6, 0xa8},
                            {0x88, 0x5a, 0x30, 0x8d},
@@ -115,6 +158,14 @@ int main() {
   static_assert(equals(plain_text.c3, {0xe0, 0x37, 0x07, 0x34}),
                 "[-][aes] bad aes decryption");
 
+  // t-table implementation against the decomposed one
+  constexpr auto fast_encryptor = ttable_aes_cipher{kraw};
+  static_assert(same_results(aes_encryptor, fast_encryptor, s, 64),
+                "[-][aes] t-table results differ");
+  static_assert(same_results(basic_aes_cipher<3>{kraw},
+                             basic_ttable_aes_cipher<1>{kraw}, s, 16),
+                "[-][aes] t-table results differ");
+
   // test aes with variable block size
   constexpr auto cipher_text_var_small =
       aes_ecb_cipher_str(kraw, make_cxstring("small str"));
@@ -124,7 +175,89 @@ int main() {
   constexpr auto cipher_text_var_large = aes_ecb_cipher_str(
       kraw, make_cxstring("this is a test string longer than 128 bits"));
 
-  // test runtime
+  // test runtime (aes-ni backend when supported) against the fips vector
+  auto const runtime_encryptor = aes_cipher{kraw};
+  auto const runtime_cipher_text = runtime_encryptor.cipher(s);
+  if (!equals(detail::pack_block(runtime_cipher_text),
+              detail::pack_block(cipher_text)) ||
+      !equals(detail::pack_block(runtime_encryptor.decipher(cipher_text)),
+              detail::pack_block(s))) {
+    std::cerr << "[-][aes] bad runtime aes" << std::endl;
+    return 1;
+  }
+
+  // multi-block backends against the t-table implementation
+  std::array<state, 17> blocks{};
+  for (std::size_t i = 0; i < blocks.size(); ++i) {
+    blocks[i] = i ? fast_encryptor.cipher(blocks[i - 1]) : s;
+  }
+  if (!same_blocks(bitsliced_aes_cipher{kraw}, fast_encryptor, blocks)) {
+    std::cerr << "[-][aes] bitsliced results differ" << std::endl;
+    return 1;
+  }
+  if (!same_blocks(runtime_encryptor, fast_encryptor, blocks)) {
+    std::cerr << "[-][aes] aes-ni results differ" << std::endl;
+    return 1;
+  }
+
+  // sp 800-38a ctr and cbc vectors (aes 128)
+  std::vector<uint8_t> const plain_blocks = {
+      0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e,
+      0x11, 0x73, 0x93, 0x17, 0x2a, 0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03,
+      0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51};
+  std::vector<uint8_t> const ctr_blocks = {
+      0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68,
+      0x64, 0x99, 0x0d, 0xb6, 0xce, 0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70,
+      0xfd, 0xff, 0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff};
+  std::vector<uint8_t> const cbc_blocks = {
+      0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e,
+      0x9b, 0x12, 0xe9, 0x19, 0x7d, 0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72,
+      0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2};
+  serial_state const counter = {0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5,
+                                0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb,
+                                0xfc, 0xfd, 0xfe, 0xff};
+  serial_state const iv = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                           0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+
+  std::vector<uint8_t> mode_out(plain_blocks.size());
+  aes_ctr(kraw, counter, plain_blocks, mode_out);
+  if (mode_out != ctr_blocks) {
+    std::cerr << "[-][aes] bad ctr ciphering" << std::endl;
+    return 1;
+  }
+  aes_cbc_cipher(kraw, iv, plain_blocks, mode_out);
+  if (mode_out != cbc_blocks) {
+    std::cerr << "[-][aes] bad cbc ciphering" << std::endl;
+    return 1;
+  }
+  aes_cbc_decipher(kraw, iv, cbc_blocks, mode_out);
+  if (mode_out != plain_blocks) {
+    std::cerr << "[-][aes] bad cbc deciphering" << std::endl;
+    return 1;
+  }
+
+  // large buffers (partial last block for ctr) split between workers
+  std::vector<uint8_t> large(1 << 20);
+  for (std::size_t i = 0; i < large.size(); ++i) {
+    large[i] = static_cast<uint8_t>(i * 31 + (i >> 8));
+  }
+  std::vector<uint8_t> large_ctr(large.size() - 5);
+  std::vector<uint8_t> large_back(large.size());
+  aes_ctr(kraw, counter, {large.data(), large_ctr.size()}, large_ctr);
+  aes_ctr(kraw, counter, large_ctr, large_back);
+  if (!std::equal(large.begin(), large.end() - 5, large_back.begin())) {
+    std::cerr << "[-][aes] ctr round trip failed" << std::endl;
+    return 1;
+  }
+
+  std::vector<uint8_t> large_cbc(large.size());
+  aes_cbc_cipher(kraw, iv, large, large_cbc);
+  aes_cbc_decipher(kraw, iv, large_cbc, large_back);
+  if (large_back != large) {
+    std::cerr << "[-][aes] cbc round trip failed" << std::endl;
+    return 1;
+  }
+
   auto plain_text_var_small =
       aes_ecb_decipher<std::vector<uint8_t>>(kraw, cipher_text_var_small);
   auto plain_text_var_large =
@@ -17,7 +17,7 @@
 #include <iostream>
 
 #include "pipet/extra/bit.h"
-#include "pipet/extra/random.h"
+#include "pipet/extra/sample.h"
 #include "pipet/pipet.h"
 
 using namespace pipet;
@@ -31,24 +31,6 @@ using namespace pipet::extra;
 namespace {
 template <std::size_t N> using num_sequence_t = std::array<std::size_t, N>;
 
-template <std::size_t N> struct n_lcg_filter {
-  using rand_type = minstand_lcg<uint32_t>;
-
-  static constexpr auto process(uint32_t offset) {
-    rand_type generator{};
-    auto counter{N};
-    num_sequence_t<N> seq{};
-
-    while (counter--) {
-      // in real world, collisions should be checked
-      seq[counter] =
-          generator.rand(counter + offset, 0, sizeof(std::size_t) * 8);
-    }
-
-    return seq;
-  }
-};
-
 template <std::size_t N> struct n_bit_mask_filter {
   template <std::size_t... Is>
   static constexpr auto bit_mask_unpack(num_sequence_t<N> seq,
@@ -64,8 +46,9 @@ template <std::size_t N> struct n_bit_mask_filter {
 
 int main() {
   constexpr std::size_t mask_size = 4;
-  using mask_generator_t =
-      pipe<n_lcg_filter<mask_size>, n_bit_mask_filter<mask_size>>;
+  // distinct bit indices (Floyd's sampling), no collision to check
+  using mask_generator_t = pipe<sample_unique<mask_size, 64>,
+                                n_bit_mask_filter<mask_size>>;
 
   constexpr auto mask1 = mask_generator_t::process(0 * mask_size);
   constexpr auto mask2 = mask_generator_t::process(1 * mask_size);
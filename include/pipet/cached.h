@@ -0,0 +1,137 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "filter.h"
+#include "helpers/clock_cache.h"
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+
+namespace pipet {
+namespace detail {
+// memoization adaptors for expensive pure filters: results are stored in a
+// bounded cache keyed by the filter input. Reversible filters get a second
+// cache for the reverse direction.
+
+template <typename F> struct cached_io {
+  using arg_type = std::decay_t<
+      helpers::front_t<typename traits::filter_traits<F>::args_type>>;
+  using ret_type = typename traits::filter_traits<F>::ret_type;
+
+  static_assert(helpers::size_v<typename traits::filter_traits<F>::args_type> ==
+                    1,
+                "[-][pipet] only single input filters can be cached");
+};
+
+template <typename F, typename Fwd, typename Rev,
+          bool = std::is_same_v<typename traits::filter_traits<F>::filter_type,
+                                filter_rev_proc>>
+struct cached_impl {
+  using arg_type = typename cached_io<F>::arg_type;
+  using ret_type = typename cached_io<F>::ret_type;
+
+  static ret_type process(arg_type const &arg) {
+    return Fwd::get().get_or_compute(
+        arg, [](arg_type const &a) { return ret_type(F::process(a)); });
+  }
+
+  static helpers::cache_stats stats() { return Fwd::get().stats(); }
+
+  static void clear() { Fwd::get().clear(); }
+};
+
+template <typename F, typename Fwd, typename Rev>
+struct cached_impl<F, Fwd, Rev, true> : cached_impl<F, Fwd, Rev, false> {
+  using base_type = cached_impl<F, Fwd, Rev, false>;
+  using typename base_type::arg_type;
+  using typename base_type::ret_type;
+
+  static arg_type reverse(ret_type const &arg) {
+    return Rev::get().get_or_compute(
+        arg, [](ret_type const &a) { return arg_type(F::reverse(a)); });
+  }
+
+  static helpers::cache_stats reverse_stats() { return Rev::get().stats(); }
+
+  static void clear() {
+    base_type::clear();
+    Rev::get().clear();
+  }
+};
+
+// one cache per thread and per adaptor type
+template <typename Key, typename Value, std::size_t Capacity, typename Hash,
+          typename Tag>
+struct thread_local_cache {
+  static helpers::clock_cache<Key, Value, Capacity, Hash> &get() {
+    thread_local helpers::clock_cache<Key, Value, Capacity, Hash> cache;
+    return cache;
+  }
+};
+
+// one cache shared by all threads
+template <typename Key, typename Value, std::size_t Capacity,
+          std::size_t Shards, typename Hash, typename Tag>
+struct shared_cache {
+  static helpers::sharded_clock_cache<Key, Value, Capacity, Shards, Hash> &
+  get() {
+    static helpers::sharded_clock_cache<Key, Value, Capacity, Shards, Hash>
+        cache;
+    return cache;
+  }
+};
+
+// distinguish the reverse cache of an adaptor from the forward one
+template <typename Adaptor> struct reverse_tag;
+} // namespace detail
+
+// memoized filter with a bounded per-thread cache (no synchronization)
+template <typename F, std::size_t Capacity,
+          typename Hash = std::hash<typename detail::cached_io<F>::arg_type>,
+          typename RHash = std::hash<typename detail::cached_io<F>::ret_type>>
+struct cached
+    : detail::cached_impl<
+          F,
+          detail::thread_local_cache<typename detail::cached_io<F>::arg_type,
+                                     typename detail::cached_io<F>::ret_type,
+                                     Capacity, Hash,
+                                     cached<F, Capacity, Hash, RHash>>,
+          detail::thread_local_cache<typename detail::cached_io<F>::ret_type,
+                                     typename detail::cached_io<F>::arg_type,
+                                     Capacity, RHash,
+                                     detail::reverse_tag<
+                                         cached<F, Capacity, Hash, RHash>>>> {
+};
+
+// memoized filter with a bounded cache shared by all threads
+template <typename F, std::size_t Capacity, std::size_t Shards = 16,
+          typename Hash = std::hash<typename detail::cached_io<F>::arg_type>,
+          typename RHash = std::hash<typename detail::cached_io<F>::ret_type>>
+struct sharded_cached
+    : detail::cached_impl<
+          F,
+          detail::shared_cache<typename detail::cached_io<F>::arg_type,
+                               typename detail::cached_io<F>::ret_type,
+                               Capacity, Shards, Hash,
+                               sharded_cached<F, Capacity, Shards, Hash, RHash>>,
+          detail::shared_cache<typename detail::cached_io<F>::ret_type,
+                               typename detail::cached_io<F>::arg_type,
+                               Capacity, Shards, RHash,
+                               detail::reverse_tag<sharded_cached<
+                                   F, Capacity, Shards, Hash, RHash>>>> {
+};
+} // namespace pipet
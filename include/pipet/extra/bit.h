@@ -14,13 +14,99 @@
 
 #pragma once
 
-#include <bitset>
+#include "pipet/helpers/cpu.h"
+#include "pipet/helpers/span.h"
+
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
+#include <string>
+#include <type_traits>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PIPET_HAS_BIT_BUILTINS 1
+#else
+#define PIPET_HAS_BIT_BUILTINS 0
+#endif
 
 namespace pipet::extra {
+namespace detail {
+// portable versions (constant evaluation on compilers without builtins)
+constexpr unsigned popcount_swar(uint64_t n) {
+  n = n - ((n >> 1) & 0x5555555555555555);
+  n = (n & 0x3333333333333333) + ((n >> 2) & 0x3333333333333333);
+  n = (n + (n >> 4)) & 0x0f0f0f0f0f0f0f0f;
+  return static_cast<unsigned>((n * 0x0101010101010101) >> 56);
+}
+
+constexpr unsigned ctz_portable(uint64_t n) {
+  return popcount_swar((n & (~n + 1)) - 1);
+}
+
+constexpr unsigned clz_portable(uint64_t n) {
+  n |= n >> 1;
+  n |= n >> 2;
+  n |= n >> 4;
+  n |= n >> 8;
+  n |= n >> 16;
+  n |= n >> 32;
+  return 64 - popcount_swar(n);
+}
+} // namespace detail
+
+#if PIPET_X86_SIMD && PIPET_HAS_BIT_BUILTINS && !defined(__POPCNT__)
+#define PIPET_POPCNT_DISPATCH 1
+#else
+#define PIPET_POPCNT_DISPATCH 0
+#endif
+
+namespace detail {
+#if PIPET_POPCNT_DISPATCH
+PIPET_TARGET("popcnt") inline unsigned popcount_popcnt(uint64_t n) {
+  return static_cast<unsigned>(__builtin_popcountll(n));
+}
+#endif
+} // namespace detail
+
+// single word operations, the builtins are constexpr and become single
+// instructions when the isa is enabled (-mpopcnt, -mbmi, -march=...). On
+// x86-64 without -mpopcnt the builtin is a libgcc call, the popcnt
+// instruction is selected at runtime instead.
 constexpr unsigned bit_count(uint64_t n) {
-  return (n ? (n & 0x1) + bit_count(n >> 1) : 0);
+#if PIPET_POPCNT_DISPATCH
+  if (!helpers::is_constant_evaluated() && helpers::cpu().popcnt) {
+    return detail::popcount_popcnt(n);
+  }
+  return detail::popcount_swar(n);
+#elif PIPET_HAS_BIT_BUILTINS
+  return static_cast<unsigned>(__builtin_popcountll(n));
+#else
+  return detail::popcount_swar(n);
+#endif
+}
+
+// number of trailing (low) zero bits, 64 for 0
+constexpr unsigned trailing_zeros(uint64_t n) {
+  if (!n) {
+    return 64;
+  }
+#if PIPET_HAS_BIT_BUILTINS
+  return static_cast<unsigned>(__builtin_ctzll(n));
+#else
+  return detail::ctz_portable(n);
+#endif
+}
+
+// number of leading (high) zero bits, 64 for 0
+constexpr unsigned leading_zeros(uint64_t n) {
+  if (!n) {
+    return 64;
+  }
+#if PIPET_HAS_BIT_BUILTINS
+  return static_cast<unsigned>(__builtin_clzll(n));
+#else
+  return detail::clz_portable(n);
+#endif
 }
 
 template <typename T, typename... Is> constexpr T bit_mask(Is... indices) {
@@ -28,6 +114,306 @@ template <typename T, typename... Is> constexpr T bit_mask(Is... indices) {
 }
 
 template <typename T> auto stringify(T n) {
-  return "0b" + std::bitset<sizeof(T) * 8>{n}.to_string();
+  using bits_type = std::make_unsigned_t<T>;
+  constexpr std::size_t bits = sizeof(T) * 8;
+
+  auto const v = static_cast<bits_type>(n);
+  std::string res(bits + 2, '0');
+  res[1] = 'b';
+  for (std::size_t i = 0; i < bits; ++i) {
+    if ((v >> i) & 1) {
+      res[bits + 1 - i] = '1';
+    }
+  }
+  return res;
+}
+
+//-------------------------------------
+// Bitmaps (spans of 64-bit words, bit i is bit i % 64 of word i / 64)
+
+namespace detail {
+struct and_op {
+  constexpr uint64_t operator()(uint64_t a, uint64_t b) const { return a & b; }
+};
+
+struct or_op {
+  constexpr uint64_t operator()(uint64_t a, uint64_t b) const { return a | b; }
+};
+
+struct xor_op {
+  constexpr uint64_t operator()(uint64_t a, uint64_t b) const { return a ^ b; }
+};
+
+struct andnot_op {
+  constexpr uint64_t operator()(uint64_t a, uint64_t b) const {
+    return a & ~b;
+  }
+};
+
+// word i of the counted bitmap (a op b, or a)
+template <typename Op> struct word_loader {
+  uint64_t const *a;
+  uint64_t const *b;
+  constexpr uint64_t operator()(std::size_t i) const {
+    return Op{}(a[i], b[i]);
+  }
+};
+
+struct plain_loader {
+  uint64_t const *a;
+  constexpr uint64_t operator()(std::size_t i) const { return a[i]; }
+};
+
+// word count without runtime dispatch (the popcnt kernels are dispatched per
+// bitmap)
+constexpr unsigned bit_count_portable(uint64_t n) {
+#if PIPET_POPCNT_DISPATCH
+  return popcount_swar(n);
+#else
+  return bit_count(n);
+#endif
+}
+
+template <typename Load>
+constexpr std::size_t count_portable(Load load, std::size_t n) {
+  std::size_t res = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    res += bit_count_portable(load(i));
+  }
+  return res;
+}
+
+template <typename Op>
+constexpr void combine_portable(uint64_t const *a, uint64_t const *b,
+                                uint64_t *out, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = Op{}(a[i], b[i]);
+  }
+}
+
+#if PIPET_X86_SIMD
+template <typename Load>
+PIPET_TARGET("popcnt")
+std::size_t count_popcnt(Load load, std::size_t n) {
+  std::size_t res = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    res += static_cast<std::size_t>(__builtin_popcountll(load(i)));
+  }
+  return res;
+}
+
+// per 64-bit lane counts of a vector (nibble lookup)
+PIPET_TARGET("avx2") inline __m256i popcount_avx2(__m256i v) {
+  auto const lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1,
+                       1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  auto const low_mask = _mm256_set1_epi8(0x0f);
+  auto const lo = _mm256_and_si256(v, low_mask);
+  auto const hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+  auto const counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                      _mm256_shuffle_epi8(lookup, hi));
+  return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+// carry save adder
+PIPET_TARGET("avx2")
+inline void csa_avx2(__m256i &h, __m256i &l, __m256i a, __m256i b, __m256i c) {
+  auto const u = _mm256_xor_si256(a, b);
+  h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+  l = _mm256_xor_si256(u, c);
+}
+
+PIPET_TARGET("avx2")
+inline __m256i load_avx2(plain_loader const &load, std::size_t v) {
+  return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(load.a + 4 * v));
+}
+
+PIPET_TARGET("avx2")
+inline __m256i load_avx2(word_loader<and_op> const &load, std::size_t v) {
+  auto const *a = reinterpret_cast<__m256i const *>(load.a + 4 * v);
+  auto const *b = reinterpret_cast<__m256i const *>(load.b + 4 * v);
+  return _mm256_and_si256(_mm256_loadu_si256(a), _mm256_loadu_si256(b));
+}
+
+// Harley-Seal popcount (Mula, Kurz, Lemire), 16 vectors per step are reduced
+// by a carry save adder tree, one vector popcount per step
+template <typename Load>
+PIPET_TARGET("avx2")
+std::size_t count_avx2(Load load, std::size_t n) {
+  auto const vectors = n / 4;
+  auto const zero = _mm256_setzero_si256();
+  __m256i total = zero, ones = zero, twos = zero, fours = zero, eights = zero;
+  __m256i sixteens, twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+  std::size_t v = 0;
+  for (; v + 16 <= vectors; v += 16) {
+    csa_avx2(twos_a, ones, ones, load_avx2(load, v), load_avx2(load, v + 1));
+    csa_avx2(twos_b, ones, ones, load_avx2(load, v + 2),
+             load_avx2(load, v + 3));
+    csa_avx2(fours_a, twos, twos, twos_a, twos_b);
+    csa_avx2(twos_a, ones, ones, load_avx2(load, v + 4),
+             load_avx2(load, v + 5));
+    csa_avx2(twos_b, ones, ones, load_avx2(load, v + 6),
+             load_avx2(load, v + 7));
+    csa_avx2(fours_b, twos, twos, twos_a, twos_b);
+    csa_avx2(eights_a, fours, fours, fours_a, fours_b);
+    csa_avx2(twos_a, ones, ones, load_avx2(load, v + 8),
+             load_avx2(load, v + 9));
+    csa_avx2(twos_b, ones, ones, load_avx2(load, v + 10),
+             load_avx2(load, v + 11));
+    csa_avx2(fours_a, twos, twos, twos_a, twos_b);
+    csa_avx2(twos_a, ones, ones, load_avx2(load, v + 12),
+             load_avx2(load, v + 13));
+    csa_avx2(twos_b, ones, ones, load_avx2(load, v + 14),
+             load_avx2(load, v + 15));
+    csa_avx2(fours_b, twos, twos, twos_a, twos_b);
+    csa_avx2(eights_b, fours, fours, fours_a, fours_b);
+    csa_avx2(sixteens, eights, eights, eights_a, eights_b);
+    total = _mm256_add_epi64(total, popcount_avx2(sixteens));
+  }
+
+  total = _mm256_slli_epi64(total, 4);
+  total = _mm256_add_epi64(total,
+                           _mm256_slli_epi64(popcount_avx2(eights), 3));
+  total =
+      _mm256_add_epi64(total, _mm256_slli_epi64(popcount_avx2(fours), 2));
+  total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_avx2(twos), 1));
+  total = _mm256_add_epi64(total, popcount_avx2(ones));
+  for (; v < vectors; ++v) {
+    total = _mm256_add_epi64(total, popcount_avx2(load_avx2(load, v)));
+  }
+
+  alignas(32) uint64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), total);
+  std::size_t res = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  for (auto i = 4 * vectors; i < n; ++i) {
+    res += bit_count(load(i));
+  }
+  return res;
+}
+
+template <typename Op>
+PIPET_TARGET("avx2")
+void combine_avx2(uint64_t const *a, uint64_t const *b, uint64_t *out,
+                  std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto const va =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + i));
+    auto const vb =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(b + i));
+    __m256i r;
+    if constexpr (std::is_same_v<Op, and_op>) {
+      r = _mm256_and_si256(va, vb);
+    } else if constexpr (std::is_same_v<Op, or_op>) {
+      r = _mm256_or_si256(va, vb);
+    } else if constexpr (std::is_same_v<Op, xor_op>) {
+      r = _mm256_xor_si256(va, vb);
+    } else {
+      r = _mm256_andnot_si256(vb, va);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), r);
+  }
+  combine_portable<Op>(a + i, b + i, out + i, n - i);
+}
+#endif
+
+// below this size the avx2 kernel setup is not worth it
+constexpr std::size_t bitmap_simd_words = 64;
+
+template <typename Load>
+constexpr std::size_t count_dispatch(Load load, std::size_t n) {
+#if PIPET_X86_SIMD
+  if (!helpers::is_constant_evaluated()) {
+    if (n >= bitmap_simd_words && helpers::cpu().avx2) {
+      return count_avx2(load, n);
+    } else if (helpers::cpu().popcnt) {
+      return count_popcnt(load, n);
+    }
+  }
+#endif
+  return count_portable(load, n);
+}
+
+template <typename Op>
+constexpr void combine_dispatch(helpers::span<uint64_t const> a,
+                                helpers::span<uint64_t const> b,
+                                helpers::span<uint64_t> out) {
+#if PIPET_X86_SIMD
+  if (!helpers::is_constant_evaluated() && helpers::cpu().avx2) {
+    combine_avx2<Op>(a.data(), b.data(), out.data(), out.size());
+    return;
+  }
+#endif
+  combine_portable<Op>(a.data(), b.data(), out.data(), out.size());
+}
+} // namespace detail
+
+// number of set bits (avx2 harley-seal or popcnt when available)
+constexpr std::size_t bit_count(helpers::span<uint64_t const> bits) {
+  return detail::count_dispatch(detail::plain_loader{bits.data()},
+                                bits.size());
+}
+
+// number of bits set in both bitmaps (a & b), without temporary
+constexpr std::size_t bit_count_and(helpers::span<uint64_t const> a,
+                                    helpers::span<uint64_t const> b) {
+  return detail::count_dispatch(
+      detail::word_loader<detail::and_op>{a.data(), b.data()}, a.size());
+}
+
+// out = a op b word by word (out may alias a or b), all sizes are out.size()
+constexpr void bit_and(helpers::span<uint64_t const> a,
+                       helpers::span<uint64_t const> b,
+                       helpers::span<uint64_t> out) {
+  detail::combine_dispatch<detail::and_op>(a, b, out);
+}
+
+constexpr void bit_or(helpers::span<uint64_t const> a,
+                      helpers::span<uint64_t const> b,
+                      helpers::span<uint64_t> out) {
+  detail::combine_dispatch<detail::or_op>(a, b, out);
+}
+
+constexpr void bit_xor(helpers::span<uint64_t const> a,
+                       helpers::span<uint64_t const> b,
+                       helpers::span<uint64_t> out) {
+  detail::combine_dispatch<detail::xor_op>(a, b, out);
+}
+
+// out = a & ~b
+constexpr void bit_andnot(helpers::span<uint64_t const> a,
+                          helpers::span<uint64_t const> b,
+                          helpers::span<uint64_t> out) {
+  detail::combine_dispatch<detail::andnot_op>(a, b, out);
+}
+
+// index of the first set bit at or after from, 64 * bits.size() if none
+constexpr std::size_t find_next_set(helpers::span<uint64_t const> bits,
+                                    std::size_t from = 0) {
+  auto const end = 64 * bits.size();
+  if (from >= end) {
+    return end;
+  }
+
+  auto w = from / 64;
+  auto word = bits[w] & (~uint64_t{0} << (from % 64));
+  while (!word) {
+    if (++w == bits.size()) {
+      return end;
+    }
+    word = bits[w];
+  }
+  return 64 * w + trailing_zeros(word);
+}
+
+// call f(index) for each set bit in ascending order
+template <typename F>
+constexpr void for_each_set_bit(helpers::span<uint64_t const> bits, F &&f) {
+  for (std::size_t w = 0; w < bits.size(); ++w) {
+    for (auto word = bits[w]; word; word &= word - 1) {
+      f(64 * w + trailing_zeros(word));
+    }
+  }
 }
 } // namespace pipet::extra
\ No newline at end of file
@@ -14,8 +14,12 @@
 
 #pragma once
 
+#include "pipet/helpers/cpu.h"
+#include "pipet/helpers/span.h"
 #include "pipet/helpers/utils.h"
 
+#include <array>
+#include <cstdint>
 #include <limits>
 #include <type_traits>
 
@@ -29,37 +33,500 @@ namespace concept {
   }
 } // namespace concept
 
+namespace detail {
+// a * b mod m without overflow (a, b < m), m is a template parameter so that
+// reductions are divisions by a constant
+template <uint64_t m> constexpr uint64_t mul_mod(uint64_t a, uint64_t b) {
+  if constexpr (m <= (uint64_t{1} << 32)) {
+    return (a * b) % m;
+  } else {
+    uint64_t res = 0;
+    while (b) {
+      if (b & 1) {
+        res = (res >= m - a) ? res - (m - a) : res + a;
+      }
+      a = (a >= m - a) ? a - (m - a) : a + a;
+      b >>= 1;
+    }
+    return res;
+  }
+}
+
+// a^n mod m by square and multiply
+template <uint64_t m> constexpr uint64_t pow_mod(uint64_t a, uint64_t n) {
+  uint64_t res = 1 % m;
+  a %= m;
+  while (n) {
+    if (n & 1) {
+      res = mul_mod<m>(res, a);
+    }
+    a = mul_mod<m>(a, a);
+    n >>= 1;
+  }
+  return res;
+}
+
+// batches are generated by leapfrogged lanes, lane j produces the values
+// j, j + lcg_lanes, j + 2 * lcg_lanes... and steps by A^lcg_lanes mod M
+constexpr std::size_t lcg_lanes = 8;
+
+// simd lanes need M = 2^k - 1 (k <= 32), products then fit in 64 bits and are
+// reduced by folding the bits above k
+template <uint64_t M>
+constexpr bool is_simd_lcg_modulus_v =
+    M >= 3 && M <= 0xffffffffu && (M & (M + 1)) == 0;
+
+template <uint64_t M> constexpr int mersenne_bits() {
+  int k = 0;
+  while ((uint64_t{1} << k) - 1 < M) {
+    ++k;
+  }
+  return k;
+}
+
+#if PIPET_X86_SIMD
+template <uint64_t M, int K>
+PIPET_TARGET("sse2")
+inline __m128i mersenne_mul_sse2(__m128i x, __m128i a) {
+  auto const m = _mm_set1_epi64x(static_cast<long long>(M));
+  auto const p = _mm_mul_epu32(x, a);
+  auto const r = _mm_add_epi64(_mm_and_si128(p, m), _mm_srli_epi64(p, K));
+  // r < 2M, subtract M when it does not borrow
+  auto const t = _mm_sub_epi64(r, m);
+  auto const borrow =
+      _mm_sub_epi64(_mm_setzero_si128(), _mm_srli_epi64(t, 63));
+  return _mm_add_epi64(t, _mm_and_si128(m, borrow));
+}
+
+template <typename T>
+PIPET_TARGET("sse2")
+inline void store_lanes_sse2(T *out, __m128i lo, __m128i hi) {
+  auto *dst = reinterpret_cast<__m128i *>(out);
+  if constexpr (sizeof(T) == 8) {
+    _mm_storeu_si128(dst, lo);
+    _mm_storeu_si128(dst + 1, hi);
+  } else {
+    auto const l = _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 1, 2, 0));
+    auto const h = _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128(dst, _mm_unpacklo_epi64(l, h));
+  }
+}
+
+template <typename T, uint64_t M, uint64_t AK>
+PIPET_TARGET("sse2")
+void lcg_fill_sse2(uint64_t const (&lanes)[lcg_lanes], T *out,
+                   std::size_t blocks) {
+  constexpr int k = mersenne_bits<M>();
+  auto const a = _mm_set1_epi64x(static_cast<long long>(AK));
+  __m128i x[lcg_lanes / 2];
+  for (std::size_t i = 0; i < lcg_lanes / 2; ++i) {
+    x[i] = _mm_loadu_si128(reinterpret_cast<__m128i const *>(lanes + 2 * i));
+  }
+
+  for (std::size_t b = 0; b < blocks; ++b, out += lcg_lanes) {
+    store_lanes_sse2(out, x[0], x[1]);
+    store_lanes_sse2(out + 4, x[2], x[3]);
+    for (auto &v : x) {
+      v = mersenne_mul_sse2<M, k>(v, a);
+    }
+  }
+}
+
+template <uint64_t M, int K>
+PIPET_TARGET("avx2")
+inline __m256i mersenne_mul_avx2(__m256i x, __m256i a) {
+  auto const m = _mm256_set1_epi64x(static_cast<long long>(M));
+  auto const p = _mm256_mul_epu32(x, a);
+  auto const r =
+      _mm256_add_epi64(_mm256_and_si256(p, m), _mm256_srli_epi64(p, K));
+  auto const t = _mm256_sub_epi64(r, m);
+  auto const borrow =
+      _mm256_sub_epi64(_mm256_setzero_si256(), _mm256_srli_epi64(t, 63));
+  return _mm256_add_epi64(t, _mm256_and_si256(m, borrow));
+}
+
+template <typename T>
+PIPET_TARGET("avx2")
+inline void store_lanes_avx2(T *out, __m256i v) {
+  if constexpr (sizeof(T) == 8) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), v);
+  } else {
+    auto const packed = _mm256_permutevar8x32_epi32(
+        v, _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                     _mm256_castsi256_si128(packed));
+  }
+}
+
+template <typename T, uint64_t M, uint64_t AK>
+PIPET_TARGET("avx2")
+void lcg_fill_avx2(uint64_t const (&lanes)[lcg_lanes], T *out,
+                   std::size_t blocks) {
+  constexpr int k = mersenne_bits<M>();
+  auto const a = _mm256_set1_epi64x(static_cast<long long>(AK));
+  auto x0 = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(lanes));
+  auto x1 = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(lanes + 4));
+
+  for (std::size_t b = 0; b < blocks; ++b, out += lcg_lanes) {
+    store_lanes_avx2(out, x0);
+    store_lanes_avx2(out + 4, x1);
+    x0 = mersenne_mul_avx2<M, k>(x0, a);
+    x1 = mersenne_mul_avx2<M, k>(x1, a);
+  }
+}
+
+template <typename T, uint64_t M, uint64_t AK>
+void lcg_fill_lanes(uint64_t const (&lanes)[lcg_lanes], T *out,
+                    std::size_t blocks) {
+  if (helpers::cpu().avx2) {
+    lcg_fill_avx2<T, M, AK>(lanes, out, blocks);
+  } else {
+    lcg_fill_sse2<T, M, AK>(lanes, out, blocks);
+  }
+}
+#endif
+} // namespace detail
+
 template <typename T, T S, T A, T M> class mul_lcg {
   static_assert(concept ::is_lcg_compatible<T, S, A, M>(),
                 "[-][pipet] invalid lcg params");
-  T _q{M / A};
-  T _r{M % A};
+  static constexpr T _q{M / A};
+  static constexpr T _r{M % A};
+  T _state{S};
 
-  constexpr auto seed(int64_t s) const {
-    s = A * (s % _q) - _r * (s / _q);
+  // Schrage's method is only exact when M % A < M / A (and its terms fit in
+  // an int64_t), it is kept for the large moduli reduced bit by bit by mul_mod
+  static constexpr bool is_schrage_exact =
+      M > (uint64_t{1} << 32) && _r < _q &&
+      M <= static_cast<uint64_t>((std::numeric_limits<int64_t>::max)());
 
-    if (s < 0) {
-      s += M;
+  // one step, s_1 = A * s mod M (the same value as jump(s, 1))
+  static constexpr T step(T s) {
+    if constexpr (is_schrage_exact) {
+      auto const v = static_cast<int64_t>(s % M);
+      auto res = static_cast<int64_t>(A) * (v % static_cast<int64_t>(_q)) -
+                 static_cast<int64_t>(_r) * (v / static_cast<int64_t>(_q));
+      if (res < 0) {
+        res += static_cast<int64_t>(M);
+      }
+      return static_cast<T>(res);
+    } else {
+      return static_cast<T>(detail::mul_mod<M>(A % M, s % M));
     }
+  }
 
-    return s;
+  // state reached from s after round steps, s_n = A^n * s mod M
+  static constexpr T jump(T s, std::size_t round) {
+    if (!round) {
+      return s;
+    }
+    return static_cast<T>(
+        detail::mul_mod<M>(detail::pow_mod<M>(A, round), s % M));
   }
 
 public:
   constexpr mul_lcg() {}
 
-  constexpr T rand(std::size_t round) const {
-    int64_t s = S;
-    while (round--) {
-      s = seed(s);
-    }
-    return static_cast<T>(s);
-  }
+  // value of the given round from seed S (O(log round))
+  constexpr T rand(std::size_t round) const { return jump(S, round); }
 
   constexpr T rand(std::size_t round, T low, T high) const {
     return low + rand(round) % (high - low);
   }
+
+  // streaming interface, the n-th call of next returns rand(n)
+  constexpr T next() {
+    _state = step(_state);
+    return _state;
+  }
+
+  constexpr T next(T low, T high) { return low + next() % (high - low); }
+
+  // fill with the next out.size() values of the stream (same values as
+  // repeated next calls), simd lanes are used at runtime when M = 2^k - 1
+  constexpr void fill(helpers::span<T> out) {
+    std::size_t i = 0;
+#if PIPET_X86_SIMD
+    if constexpr (detail::is_simd_lcg_modulus_v<M> &&
+                  (sizeof(T) == 4 || sizeof(T) == 8)) {
+      if (!helpers::is_constant_evaluated() &&
+          out.size() >= detail::lcg_lanes) {
+        constexpr auto ak = detail::pow_mod<M>(A, detail::lcg_lanes);
+        uint64_t lanes[detail::lcg_lanes] = {};
+        for (auto &l : lanes) {
+          l = next();
+        }
+
+        auto const blocks = out.size() / detail::lcg_lanes;
+        detail::lcg_fill_lanes<T, M, ak>(lanes, out.data(), blocks);
+        i = blocks * detail::lcg_lanes;
+        _state = out[i - 1];
+      }
+    }
+#endif
+    for (; i < out.size(); ++i) {
+      out[i] = next();
+    }
+  }
+
+  constexpr void fill(helpers::span<T> out, T low, T high) {
+    fill(out);
+    for (auto &v : out) {
+      v = low + v % (high - low);
+    }
+  }
+
+  // skip n values of the stream (O(log n))
+  constexpr void discard(std::size_t n) { _state = jump(_state, n); }
+
+  constexpr T state() const { return _state; }
 };
 
 template <typename T> using minstand_lcg = mul_lcg<T, 1u, 16807, 2147483647>;
+
+namespace detail {
+// high half of a * b (no 128-bit integer needed)
+constexpr uint64_t mul_hi(uint64_t a, uint64_t b) {
+  uint64_t const a_lo = a & 0xffffffff, a_hi = a >> 32;
+  uint64_t const b_lo = b & 0xffffffff, b_hi = b >> 32;
+  uint64_t const lo_hi = a_lo * b_hi, hi_lo = a_hi * b_lo;
+  uint64_t const mid =
+      ((a_lo * b_lo) >> 32) + (lo_hi & 0xffffffff) + (hi_lo & 0xffffffff);
+  return a_hi * b_hi + (lo_hi >> 32) + (hi_lo >> 32) + (mid >> 32);
+}
+
+// value in [0, range) by multiply-shift (no division)
+template <typename T> constexpr T scale(T v, T range) {
+  if constexpr (sizeof(T) <= 4) {
+    return static_cast<T>((uint64_t{v} * range) >> (8 * sizeof(T)));
+  } else {
+    return static_cast<T>(mul_hi(v, range));
+  }
+}
+
+// interface shared by the stateful engines below (Derived provides next())
+template <typename Derived, typename T> class engine_base {
+  constexpr Derived &self() { return static_cast<Derived &>(*this); }
+
+public:
+  using result_type = T;
+
+  // uniform random bit generator requirements (std distributions)
+  static constexpr T min() { return 0; }
+  static constexpr T max() { return (std::numeric_limits<T>::max)(); }
+  constexpr T operator()() { return self().next(); }
+
+  constexpr T next(T low, T high) {
+    return low + scale<T>(self().next(), high - low);
+  }
+
+  constexpr void fill(helpers::span<T> out) {
+    for (auto &v : out) {
+      v = self().next();
+    }
+  }
+
+  constexpr void fill(helpers::span<T> out, T low, T high) {
+    for (auto &v : out) {
+      v = next(low, high);
+    }
+  }
+};
+} // namespace detail
+
+// Engines below return values in [low, high) by multiply-shift instead of
+// modulo. Independent streams for threads or pipeline shards are obtained with
+// split (splitmix64), jump/long_jump/stream (xoshiro256ss) or stream
+// selection (pcg32), without any shared state.
+
+// splitmix64 (Steele, Lea, Flood), weyl sequence through a 64-bit mixer,
+// O(1) random access
+class splitmix64 : public detail::engine_base<splitmix64, uint64_t> {
+  static constexpr uint64_t gamma = 0x9e3779b97f4a7c15;
+  uint64_t _seed;
+  uint64_t _state;
+
+  static constexpr uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+  }
+
+public:
+  using engine_base::next;
+
+  constexpr explicit splitmix64(uint64_t seed = 0)
+      : _seed{seed}, _state{seed} {}
+
+  // the n-th call of next returns rand(n)
+  constexpr uint64_t rand(std::size_t round) const {
+    return mix(_seed + round * gamma);
+  }
+
+  constexpr uint64_t rand(std::size_t round, uint64_t low,
+                          uint64_t high) const {
+    return low + detail::scale<uint64_t>(rand(round), high - low);
+  }
+
+  constexpr uint64_t next() {
+    _state += gamma;
+    return mix(_state);
+  }
+
+  constexpr void discard(std::size_t n) { _state += n * gamma; }
+
+  // new generator seeded from this stream
+  constexpr splitmix64 split() { return splitmix64{next()}; }
+
+  constexpr uint64_t state() const { return _state; }
+};
+
+// xoshiro256** (Blackman, Vigna), seeded through splitmix64
+class xoshiro256ss : public detail::engine_base<xoshiro256ss, uint64_t> {
+  uint64_t _s[4]{};
+
+  static constexpr uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  // sum of the states selected by a jump polynomial
+  constexpr void apply_jump(uint64_t const (&poly)[4]) {
+    uint64_t s[4]{};
+    for (auto const p : poly) {
+      for (int b = 0; b < 64; ++b) {
+        if ((p >> b) & 1) {
+          for (int i = 0; i < 4; ++i) {
+            s[i] ^= _s[i];
+          }
+        }
+        next();
+      }
+    }
+    for (int i = 0; i < 4; ++i) {
+      _s[i] = s[i];
+    }
+  }
+
+public:
+  using engine_base::next;
+
+  constexpr explicit xoshiro256ss(uint64_t seed = 0) {
+    splitmix64 sm{seed};
+    for (auto &s : _s) {
+      s = sm.next();
+    }
+  }
+
+  // state must not be all zeros
+  constexpr explicit xoshiro256ss(std::array<uint64_t, 4> const &state)
+      : _s{state[0], state[1], state[2], state[3]} {}
+
+  constexpr uint64_t next() {
+    auto const res = rotl(_s[1] * 5, 7) * 9;
+    auto const t = _s[1] << 17;
+
+    _s[2] ^= _s[0];
+    _s[3] ^= _s[1];
+    _s[1] ^= _s[2];
+    _s[0] ^= _s[3];
+    _s[2] ^= t;
+    _s[3] = rotl(_s[3], 45);
+
+    return res;
+  }
+
+  // O(n), use jump for independent streams
+  constexpr void discard(std::size_t n) {
+    while (n--) {
+      next();
+    }
+  }
+
+  // advance by 2^128 values (2^128 non-overlapping streams)
+  constexpr void jump() {
+    apply_jump({0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa,
+                0x39abdc4529b1661c});
+  }
+
+  // advance by 2^192 values (2^64 groups of 2^64 jump streams)
+  constexpr void long_jump() {
+    apply_jump({0x76e15d3efefdcbbf, 0xc5004e441c522fb3, 0x77710069854ee241,
+                0x39109bb02acbe635});
+  }
+
+  // copy of this generator advanced by i jumps (stream of the i-th shard)
+  constexpr xoshiro256ss stream(std::size_t i) const {
+    auto res = *this;
+    while (i--) {
+      res.jump();
+    }
+    return res;
+  }
+
+  constexpr std::array<uint64_t, 4> state() const {
+    return {_s[0], _s[1], _s[2], _s[3]};
+  }
+};
+
+// pcg32 (O'Neill), 64-bit lcg with xsh-rr output, 2^63 selectable streams,
+// O(log n) random access
+class pcg32 : public detail::engine_base<pcg32, uint32_t> {
+  static constexpr uint64_t mult = 6364136223846793005;
+  uint64_t _inc;
+  uint64_t _init{0};
+  uint64_t _state{0};
+
+  static constexpr uint32_t output(uint64_t s) {
+    auto const x = static_cast<uint32_t>(((s >> 18) ^ s) >> 27);
+    auto const rot = static_cast<uint32_t>(s >> 59);
+    return (x >> rot) | (x << ((32 - rot) & 31));
+  }
+
+  // lcg state after delta steps (Brown, arbitrary stride ahead)
+  constexpr uint64_t advance(uint64_t s, uint64_t delta) const {
+    uint64_t acc_mult = 1, acc_plus = 0;
+    uint64_t cur_mult = mult, cur_plus = _inc;
+    while (delta) {
+      if (delta & 1) {
+        acc_mult *= cur_mult;
+        acc_plus = acc_plus * cur_mult + cur_plus;
+      }
+      cur_plus = (cur_mult + 1) * cur_plus;
+      cur_mult *= cur_mult;
+      delta >>= 1;
+    }
+    return acc_mult * s + acc_plus;
+  }
+
+public:
+  using engine_base::next;
+
+  constexpr explicit pcg32(uint64_t seed = 0x853c49e6748fea9b,
+                           uint64_t stream = 0xda3e39cb94b95bdb)
+      : _inc{(stream << 1) | 1} {
+    _state = (_inc + seed) * mult + _inc;
+    _init = _state;
+  }
+
+  // the n-th call of next returns rand(n)
+  constexpr uint32_t rand(std::size_t round) const {
+    return output(advance(_init, uint64_t{round} - 1));
+  }
+
+  constexpr uint32_t rand(std::size_t round, uint32_t low,
+                          uint32_t high) const {
+    return low + detail::scale<uint32_t>(rand(round), high - low);
+  }
+
+  constexpr uint32_t next() {
+    auto const old = _state;
+    _state = _state * mult + _inc;
+    return output(old);
+  }
+
+  // O(log n)
+  constexpr void discard(std::size_t n) { _state = advance(_state, n); }
+
+  constexpr uint64_t state() const { return _state; }
+};
 } // namespace pipet::extra
\ No newline at end of file
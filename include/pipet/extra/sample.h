@@ -0,0 +1,145 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "pipet/extra/random.h"
+#include "pipet/helpers/span.h"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace pipet::extra {
+namespace detail {
+// populations up to this size track drawn indices in a bitset, larger ones
+// scan the indices drawn so far
+constexpr std::size_t sample_bitset_limit = 4096;
+
+// Floyd's algorithm, K draws for K distinct indices in [0, N), insert returns
+// false when the index was already drawn
+template <std::size_t K, std::size_t N, typename Engine, typename Insert>
+constexpr void floyd_sample(Engine &gen, Insert &&insert) {
+  using value_type = typename Engine::result_type;
+  static_assert(K <= N, "[-][pipet] sample larger than population");
+  static_assert(N <= (std::numeric_limits<value_type>::max)(),
+                "[-][pipet] population too large for engine");
+
+  for (std::size_t j = N - K; j < N; ++j) {
+    auto const t = static_cast<std::size_t>(
+        gen.next(value_type{0}, static_cast<value_type>(j + 1)));
+    if (!insert(t)) {
+      insert(j);
+    }
+  }
+}
+} // namespace detail
+
+// filter drawing K distinct indices in [0, N) from a seed (constexpr, K engine
+// draws, no heap), Engine is constructible from a 64-bit seed
+template <std::size_t K, std::size_t N, typename Engine = pcg32>
+struct sample_unique {
+  using index_array = std::array<std::size_t, K>;
+
+  // next sample of a stream, indices in draw order
+  static constexpr index_array draw(Engine &gen) {
+    index_array res{};
+    std::size_t count = 0;
+
+    if constexpr (N <= detail::sample_bitset_limit) {
+      std::array<uint64_t, (N + 63) / 64> drawn{};
+      detail::floyd_sample<K, N>(gen, [&](std::size_t i) {
+        auto const bit = uint64_t{1} << (i % 64);
+        if (drawn[i / 64] & bit) {
+          return false;
+        }
+        drawn[i / 64] |= bit;
+        res[count++] = i;
+        return true;
+      });
+    } else {
+      detail::floyd_sample<K, N>(gen, [&](std::size_t i) {
+        for (std::size_t k = 0; k < count; ++k) {
+          if (res[k] == i) {
+            return false;
+          }
+        }
+        res[count++] = i;
+        return true;
+      });
+    }
+
+    return res;
+  }
+
+  static constexpr index_array process(uint64_t seed) {
+    Engine gen{seed};
+    return draw(gen);
+  }
+
+  // one sample per seed (pipe batch interface)
+  static void process_batch(helpers::span<uint64_t const> seeds,
+                            helpers::span<index_array> out) {
+    for (std::size_t i = 0; i < seeds.size(); ++i) {
+      out[i] = process(seeds[i]);
+    }
+  }
+
+  // consecutive samples of a stream
+  static void fill(Engine &gen, helpers::span<index_array> out) {
+    for (auto &s : out) {
+      s = draw(gen);
+    }
+  }
+};
+
+// filter drawing a mask of T with exactly K bits set
+template <std::size_t K, typename T = uint64_t, typename Engine = pcg32>
+struct sample_unique_mask {
+  static_assert(std::is_integral_v<T> && std::is_unsigned_v<T>,
+                "[-][pipet] mask must be unsigned");
+
+  static constexpr T draw(Engine &gen) {
+    T res{0};
+    detail::floyd_sample<K, 8 * sizeof(T)>(gen, [&](std::size_t i) {
+      auto const bit = static_cast<T>(T{1} << i);
+      if (res & bit) {
+        return false;
+      }
+      res |= bit;
+      return true;
+    });
+    return res;
+  }
+
+  static constexpr T process(uint64_t seed) {
+    Engine gen{seed};
+    return draw(gen);
+  }
+
+  static void process_batch(helpers::span<uint64_t const> seeds,
+                            helpers::span<T> out) {
+    for (std::size_t i = 0; i < seeds.size(); ++i) {
+      out[i] = process(seeds[i]);
+    }
+  }
+
+  static void fill(Engine &gen, helpers::span<T> out) {
+    for (auto &m : out) {
+      m = draw(gen);
+    }
+  }
+};
+} // namespace pipet::extra
\ No newline at end of file
@@ -23,6 +23,9 @@ namespace pipet {
 // Branch
 template <typename... Ts> struct branches {};
 
+// Branch evaluated concurrently on the shared thread pool
+template <typename... Ts> struct par_branches {};
+
 // Filter types
 struct filter_gen;      // data generator
 struct filter_proc;     // data processor
@@ -47,6 +50,9 @@ template <typename F> struct filter_traits_impl {
   // args type
   using args_type = decltype(helpers::function_args(&F::process));
 
+  // params type (as declared)
+  using params_type = decltype(helpers::function_params(&F::process));
+
   // filter type
   static constexpr auto is_reversible =
       has_reverse(helpers::type<F>, helpers::type<ret_type>);
@@ -75,17 +81,22 @@ template <typename F> struct filter_traits {
   using ret_type =
       std::decay_t<typename detail::filter_traits_impl<F>::ret_type>;
   using args_type = typename detail::filter_traits_impl<F>::args_type;
+  using params_type = typename detail::filter_traits_impl<F>::params_type;
   using filter_type = detail::filter_type_selector_t<F>;
 };
 
 template <> struct filter_traits<placeholders::self> {
   using ret_type = helpers::nonsuch;
   using args_type = helpers::typelist<>;
+  using params_type = helpers::typelist<>;
   using filter_type = filter_proc;
 };
 
 template <typename P, typename... Ps>
 struct filter_traits<branches<P, Ps...>> : filter_traits<P> {};
+
+template <typename P, typename... Ps>
+struct filter_traits<par_branches<P, Ps...>> : filter_traits<P> {};
 } // namespace traits
 
 namespace concept {
@@ -102,6 +113,9 @@ namespace concept {
                                   std::is_convertible_v<f_ret_type, r_arg_type>;
   };
 
+  template <typename F, typename R>
+  struct io_checker<F, R, filter_gen> : io_checker<F, R, filter_proc> {};
+
   template <typename F, typename R>
   struct io_checker<F, R, filter_rev_proc> : io_checker<F, R, filter_proc> {
     using r_args_type = typename traits::filter_traits<R>::args_type;
@@ -0,0 +1,237 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace pipet::helpers {
+struct cache_stats {
+  std::size_t hits{0};
+  std::size_t misses{0};
+};
+
+// bounded map with open-addressing lookup (linear probing) and CLOCK
+// (second chance) eviction
+template <typename Key, typename Value, std::size_t Capacity,
+          typename Hash = std::hash<Key>>
+class clock_cache {
+  static_assert(Capacity > 0 && Capacity < UINT32_MAX / 2,
+                "[-][pipet] invalid cache capacity");
+
+  static constexpr std::size_t index_size() {
+    std::size_t n = 1;
+    while (n < 2 * Capacity) {
+      n <<= 1;
+    }
+    return n;
+  }
+
+  static constexpr std::uint32_t empty_slot = UINT32_MAX;
+  static constexpr std::size_t mask = index_size() - 1;
+
+  struct entry {
+    std::optional<Key> key;
+    std::optional<Value> value;
+    std::size_t hash{0};
+    bool referenced{false};
+  };
+
+  std::vector<entry> m_entries = std::vector<entry>(Capacity);
+  std::vector<std::uint32_t> m_index =
+      std::vector<std::uint32_t>(index_size(), empty_slot);
+  std::size_t m_size{0};
+  std::size_t m_hand{0};
+  cache_stats m_stats;
+
+  std::size_t find_slot(Key const &k, std::size_t h) const {
+    auto pos = h & mask;
+    while (m_index[pos] != empty_slot) {
+      auto const &e = m_entries[m_index[pos]];
+      if (e.hash == h && *e.key == k) {
+        return pos;
+      }
+      pos = (pos + 1) & mask;
+    }
+    return pos;
+  }
+
+  // backward shift deletion keeps probe sequences without tombstones
+  void erase_slot(std::size_t i) {
+    auto j = i;
+    for (;;) {
+      j = (j + 1) & mask;
+      if (m_index[j] == empty_slot) {
+        break;
+      }
+
+      auto const home = m_entries[m_index[j]].hash & mask;
+      auto const movable = (i <= j) ? (home <= i || home > j)
+                                    : (home <= i && home > j);
+      if (movable) {
+        m_index[i] = m_index[j];
+        i = j;
+      }
+    }
+    m_index[i] = empty_slot;
+  }
+
+  std::size_t evict() {
+    while (m_entries[m_hand].referenced) {
+      m_entries[m_hand].referenced = false;
+      m_hand = (m_hand + 1) % Capacity;
+    }
+
+    auto const victim = m_hand;
+    m_hand = (m_hand + 1) % Capacity;
+
+    auto const &e = m_entries[victim];
+    erase_slot(find_slot(*e.key, e.hash));
+    return victim;
+  }
+
+public:
+  static constexpr std::size_t capacity() { return Capacity; }
+
+  std::size_t size() const { return m_size; }
+
+  cache_stats stats() const { return m_stats; }
+
+  Value const *find(Key const &k, std::size_t h) {
+    auto const slot = m_index[find_slot(k, h)];
+    if (slot == empty_slot) {
+      ++m_stats.misses;
+      return nullptr;
+    }
+
+    auto &e = m_entries[slot];
+    e.referenced = true;
+    ++m_stats.hits;
+    return &*e.value;
+  }
+
+  Value const *find(Key const &k) { return find(k, Hash{}(k)); }
+
+  void insert(Key const &k, std::size_t h, Value v) {
+    auto const pos = find_slot(k, h);
+    if (m_index[pos] != empty_slot) {
+      // already inserted meanwhile
+      return;
+    }
+
+    auto const idx = (m_size < Capacity) ? m_size++ : evict();
+    auto &e = m_entries[idx];
+    e.key = k;
+    e.value = std::move(v);
+    e.hash = h;
+    e.referenced = false;
+
+    // eviction may have shifted the probe sequence
+    m_index[find_slot(k, h)] = static_cast<std::uint32_t>(idx);
+  }
+
+  void insert(Key const &k, Value v) { insert(k, Hash{}(k), std::move(v)); }
+
+  template <typename Fn> Value get_or_compute(Key const &k, Fn &&fn) {
+    auto const h = Hash{}(k);
+    if (auto v = find(k, h)) {
+      return *v;
+    }
+
+    auto v = std::forward<Fn>(fn)(k);
+    insert(k, h, v);
+    return v;
+  }
+
+  void clear() {
+    for (auto &e : m_entries) {
+      e = entry{};
+    }
+    std::fill(m_index.begin(), m_index.end(), empty_slot);
+    m_size = m_hand = 0;
+    m_stats = cache_stats{};
+  }
+};
+
+// thread-safe cache split into independently locked shards
+template <typename Key, typename Value, std::size_t Capacity,
+          std::size_t Shards, typename Hash = std::hash<Key>>
+class sharded_clock_cache {
+  static_assert(Shards > 0 && Capacity >= Shards && Capacity % Shards == 0,
+                "[-][pipet] invalid cache sharding (capacity must be a "
+                "multiple of the shard count)");
+
+  struct alignas(64) shard {
+    std::mutex mutex;
+    clock_cache<Key, Value, Capacity / Shards, Hash> cache;
+  };
+
+  std::array<shard, Shards> m_shards;
+
+  shard &shard_for(std::size_t h) {
+    // hash mixed first (std::hash is the identity for integers on some
+    // standard libraries), the slot inside the shard uses the plain hash
+    auto x = static_cast<std::uint64_t>(h);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return m_shards[x % Shards];
+  }
+
+public:
+  template <typename Fn> Value get_or_compute(Key const &k, Fn &&fn) {
+    auto const h = Hash{}(k);
+    auto &s = shard_for(h);
+    {
+      std::lock_guard<std::mutex> lock{s.mutex};
+      if (auto v = s.cache.find(k, h)) {
+        return *v;
+      }
+    }
+
+    // computation is done out of the lock
+    auto v = std::forward<Fn>(fn)(k);
+    {
+      std::lock_guard<std::mutex> lock{s.mutex};
+      s.cache.insert(k, h, v);
+    }
+    return v;
+  }
+
+  cache_stats stats() {
+    cache_stats res;
+    for (auto &s : m_shards) {
+      std::lock_guard<std::mutex> lock{s.mutex};
+      res.hits += s.cache.stats().hits;
+      res.misses += s.cache.stats().misses;
+    }
+    return res;
+  }
+
+  void clear() {
+    for (auto &s : m_shards) {
+      std::lock_guard<std::mutex> lock{s.mutex};
+      s.cache.clear();
+    }
+  }
+};
+} // namespace pipet::helpers
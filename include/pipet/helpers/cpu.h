@@ -0,0 +1,137 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+// x86-64 simd kernels (sse2 baseline, wider isa selected at runtime),
+// PIPET_DISABLE_SIMD forces the portable paths
+#if !defined(PIPET_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define PIPET_X86_SIMD 1
+#else
+#define PIPET_X86_SIMD 0
+#endif
+
+#if PIPET_X86_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// compile a function for an isa not enabled on the command line
+#if defined(__GNUC__) || defined(__clang__)
+#define PIPET_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PIPET_TARGET(isa)
+#endif
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define PIPET_HAS_CONSTANT_EVALUATED 1
+#endif
+#endif
+
+#ifndef PIPET_HAS_CONSTANT_EVALUATED
+#if (defined(__GNUC__) && __GNUC__ >= 9) ||                                    \
+    (defined(_MSC_VER) && _MSC_VER >= 1925)
+#define PIPET_HAS_CONSTANT_EVALUATED 1
+#else
+#define PIPET_HAS_CONSTANT_EVALUATED 0
+#endif
+#endif
+
+namespace pipet::helpers {
+// true in a constant evaluation, also true when the compiler cannot tell so
+// that runtime only paths (simd, ...) are never selected in a constexpr call
+constexpr bool is_constant_evaluated() noexcept {
+#if PIPET_HAS_CONSTANT_EVALUATED
+  return __builtin_is_constant_evaluated();
+#else
+  return true;
+#endif
+}
+
+// isa extensions usable at runtime (cpu and os support)
+struct cpu_features {
+  bool sse2{false};
+  bool ssse3{false};
+  bool sse41{false};
+  bool avx2{false};
+  bool aes{false};
+  bool pclmul{false};
+  bool popcnt{false};
+};
+
+namespace detail {
+#if PIPET_X86_SIMD
+inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t (&regs)[4]) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int r[4];
+  __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+  for (int i = 0; i < 4; ++i) {
+    regs[i] = static_cast<uint32_t>(r[i]);
+  }
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+inline uint64_t xgetbv0() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  return _xgetbv(0);
+#else
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+inline cpu_features detect_cpu_features() {
+  cpu_features res{};
+#if PIPET_X86_SIMD
+  uint32_t regs[4];
+  cpuid(0, 0, regs);
+  auto const max_leaf = regs[0];
+
+  cpuid(1, 0, regs);
+  res.sse2 = (regs[3] >> 26) & 1;
+  res.ssse3 = (regs[2] >> 9) & 1;
+  res.sse41 = (regs[2] >> 19) & 1;
+  res.aes = (regs[2] >> 25) & 1;
+  res.pclmul = (regs[2] >> 1) & 1;
+  res.popcnt = (regs[2] >> 23) & 1;
+
+  // avx state must be saved by the os
+  bool const osxsave = (regs[2] >> 27) & 1;
+  bool const avx = (regs[2] >> 28) & 1;
+  if (max_leaf >= 7 && osxsave && avx && (xgetbv0() & 0x6) == 0x6) {
+    cpuid(7, 0, regs);
+    res.avx2 = (regs[1] >> 5) & 1;
+  }
+#endif
+  return res;
+}
+} // namespace detail
+
+// detected once
+inline cpu_features const &cpu() {
+  static cpu_features const features = detail::detect_cpu_features();
+  return features;
+}
+} // namespace pipet::helpers
@@ -16,6 +16,7 @@
 
 #include "typelist.h"
 
+#include <string_view>
 #include <type_traits>
 #include <utility>
 
@@ -71,7 +72,50 @@ template <typename T> T value_t(type_t<T>);
 // function return type
 template <typename Ret, typename... Args> Ret function_ret(Ret(Args...));
 
+template <typename Ret, typename C, typename... Args>
+Ret function_ret(Ret (C::*)(Args...));
+
+template <typename Ret, typename C, typename... Args>
+Ret function_ret(Ret (C::*)(Args...) const);
+
 // function args type
 template <typename Ret, typename... Args>
 typelist<std::decay_t<Args>...> function_args(Ret(Args...));
+
+template <typename Ret, typename C, typename... Args>
+typelist<std::decay_t<Args>...> function_args(Ret (C::*)(Args...));
+
+template <typename Ret, typename C, typename... Args>
+typelist<std::decay_t<Args>...> function_args(Ret (C::*)(Args...) const);
+
+// function params type (reference and value categories kept)
+template <typename Ret, typename... Args>
+typelist<Args...> function_params(Ret(Args...));
+
+template <typename Ret, typename C, typename... Args>
+typelist<Args...> function_params(Ret (C::*)(Args...));
+
+template <typename Ret, typename C, typename... Args>
+typelist<Args...> function_params(Ret (C::*)(Args...) const);
+
+// readable type name (compiler specific spelling, for reports only)
+template <typename T> constexpr std::string_view type_name() {
+#if defined(__clang__) || defined(__GNUC__)
+  // "... type_name() [with T = X; std::string_view = ...]" (gcc)
+  // "... type_name() [T = X]" (clang)
+  constexpr std::string_view fn = __PRETTY_FUNCTION__;
+  constexpr auto begin = fn.find("T = ") + 4;
+  constexpr auto end = fn.find("; std::string_view", begin);
+  return fn.substr(begin,
+                   (end == std::string_view::npos ? fn.size() - 1 : end) -
+                       begin);
+#elif defined(_MSC_VER)
+  // "... type_name<X>(void)"
+  constexpr std::string_view fn = __FUNCSIG__;
+  constexpr auto begin = fn.find("type_name<") + 10;
+  return fn.substr(begin, fn.rfind(">(void)") - begin);
+#else
+  return "unknown";
+#endif
+}
 } // namespace pipet::helpers
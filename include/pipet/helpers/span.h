@@ -0,0 +1,62 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+namespace pipet::helpers {
+// minimal contiguous view (to be replaced by std::span from c++20)
+template <typename T> class span {
+  T *m_data{nullptr};
+  std::size_t m_size{0};
+
+public:
+  using element_type = T;
+  using value_type = std::remove_cv_t<T>;
+
+  constexpr span() = default;
+
+  constexpr span(T *data, std::size_t size) : m_data{data}, m_size{size} {}
+
+  template <std::size_t N>
+  constexpr span(T (&arr)[N]) : m_data{arr}, m_size{N} {}
+
+  // any contiguous container exposing data() and size()
+  template <typename Container,
+            typename = std::enable_if_t<std::is_convertible_v<
+                decltype(std::declval<Container &>().data()), T *>>>
+  constexpr span(Container &c) : m_data{c.data()}, m_size{c.size()} {}
+
+  // span<T> to span<T const> conversion
+  template <typename U, typename = std::enable_if_t<
+                            std::is_convertible_v<U (*)[], T (*)[]>>>
+  constexpr span(span<U> const &s) : m_data{s.data()}, m_size{s.size()} {}
+
+  constexpr T *data() const { return m_data; }
+  constexpr std::size_t size() const { return m_size; }
+  constexpr bool empty() const { return m_size == 0; }
+
+  constexpr T &operator[](std::size_t idx) const { return m_data[idx]; }
+
+  constexpr T *begin() const { return m_data; }
+  constexpr T *end() const { return m_data + m_size; }
+
+  constexpr span subspan(std::size_t offset, std::size_t count) const {
+    return span{m_data + offset, count};
+  }
+};
+} // namespace pipet::helpers
@@ -0,0 +1,152 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace pipet::helpers {
+// avoid false sharing between producer and consumer data
+inline constexpr std::size_t cache_line_size = 64;
+
+// bounded lock-free single-producer/single-consumer ring buffer
+template <typename T, std::size_t Capacity> class spsc_queue {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "[-][pipet] queue capacity must be a power of two");
+
+  using storage_type = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+  // consumer side
+  alignas(cache_line_size) std::atomic<std::size_t> m_head{0};
+  std::size_t m_tail_cache{0};
+
+  // producer side
+  alignas(cache_line_size) std::atomic<std::size_t> m_tail{0};
+  std::size_t m_head_cache{0};
+
+  alignas(cache_line_size) storage_type m_slots[Capacity];
+
+  T *slot(std::size_t idx) {
+    return std::launder(reinterpret_cast<T *>(&m_slots[idx & (Capacity - 1)]));
+  }
+
+public:
+  spsc_queue() = default;
+  spsc_queue(spsc_queue const &) = delete;
+  spsc_queue &operator=(spsc_queue const &) = delete;
+
+  ~spsc_queue() {
+    while (try_pop()) {
+    }
+  }
+
+  static constexpr std::size_t capacity() { return Capacity; }
+
+  // producer only
+  template <typename... Args> bool try_emplace(Args &&... args) {
+    auto const tail = m_tail.load(std::memory_order_relaxed);
+
+    if (tail - m_head_cache == Capacity) {
+      m_head_cache = m_head.load(std::memory_order_acquire);
+      if (tail - m_head_cache == Capacity) {
+        return false;
+      }
+    }
+
+    ::new (&m_slots[tail & (Capacity - 1)]) T(std::forward<Args>(args)...);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_push(T &&v) { return try_emplace(std::move(v)); }
+  bool try_push(T const &v) { return try_emplace(v); }
+
+  // consumer only
+  std::optional<T> try_pop() {
+    auto const head = m_head.load(std::memory_order_relaxed);
+
+    if (head == m_tail_cache) {
+      m_tail_cache = m_tail.load(std::memory_order_acquire);
+      if (head == m_tail_cache) {
+        return std::nullopt;
+      }
+    }
+
+    auto *item = slot(head);
+    std::optional<T> res{std::move(*item)};
+    item->~T();
+    m_head.store(head + 1, std::memory_order_release);
+    return res;
+  }
+
+  // approximate when not called from producer or consumer
+  bool empty() const {
+    return m_head.load(std::memory_order_acquire) ==
+           m_tail.load(std::memory_order_acquire);
+  }
+
+  bool full() const {
+    return m_tail.load(std::memory_order_acquire) -
+               m_head.load(std::memory_order_acquire) ==
+           Capacity;
+  }
+};
+
+// wait for a condition on a queue (not empty, not full, closed...): polled
+// for a bounded number of spins, then the waiter sleeps until notified. A
+// notification costs a fence and a load while nobody sleeps.
+class queue_waiter {
+  std::atomic<std::size_t> m_sleepers{0};
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+
+public:
+  static constexpr int spin_count = 64;
+
+  template <typename Pred> void wait(Pred ready) {
+    for (int i = 0; i < spin_count; ++i) {
+      if (ready()) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_sleepers.fetch_add(1, std::memory_order_relaxed);
+    // pairs with the fence of notify: the condition is seen true here or the
+    // sleeper is seen there
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    m_cv.wait(lock, ready);
+    m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // call once the condition may have become true
+  void notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleepers.load(std::memory_order_relaxed) != 0) {
+      // the sleeper is either waiting or still holds the mutex
+      { std::lock_guard<std::mutex> lock{m_mutex}; }
+      m_cv.notify_all();
+    }
+  }
+};
+} // namespace pipet::helpers
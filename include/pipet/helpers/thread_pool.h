@@ -0,0 +1,182 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace pipet::helpers {
+// fixed size pool of workers consuming a shared task queue
+class thread_pool {
+  std::vector<std::thread> m_workers;
+  std::deque<std::function<void()>> m_tasks;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_stop{false};
+
+  void work() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_cv.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+
+        if (m_tasks.empty()) {
+          return;
+        }
+
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+public:
+  explicit thread_pool(std::size_t size = default_size()) {
+    m_workers.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      m_workers.emplace_back([this] { work(); });
+    }
+  }
+
+  thread_pool(thread_pool const &) = delete;
+  thread_pool &operator=(thread_pool const &) = delete;
+
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_stop = true;
+    }
+    m_cv.notify_all();
+
+    for (auto &w : m_workers) {
+      w.join();
+    }
+  }
+
+  static std::size_t default_size() {
+    auto const n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+  }
+
+  // process-wide pool shared by all parallel elements
+  static thread_pool &shared() {
+    static thread_pool pool;
+    return pool;
+  }
+
+  std::size_t size() const { return m_workers.size(); }
+
+  void post(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_tasks.emplace_back(std::move(task));
+    }
+    m_cv.notify_one();
+  }
+
+  // run one queued task on the calling thread if any
+  bool run_pending() {
+    std::function<void()> task;
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      if (m_tasks.empty()) {
+        return false;
+      }
+
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    task();
+    return true;
+  }
+};
+
+// set of tasks posted to a pool and joined together
+class task_group {
+  thread_pool &m_pool;
+  std::atomic<std::size_t> m_pending{0};
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::exception_ptr m_error;
+
+  void done(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (error && !m_error) {
+      m_error = std::move(error);
+    }
+
+    if (--m_pending == 0) {
+      m_cv.notify_all();
+    }
+  }
+
+public:
+  explicit task_group(thread_pool &pool = thread_pool::shared())
+      : m_pool{pool} {}
+
+  task_group(task_group const &) = delete;
+  task_group &operator=(task_group const &) = delete;
+
+  ~task_group() { wait_noexcept(); }
+
+  template <typename F> void run(F &&f) {
+    ++m_pending;
+    m_pool.post([this, f = std::forward<F>(f)]() mutable {
+      std::exception_ptr error;
+      try {
+        f();
+      } catch (...) {
+        error = std::current_exception();
+      }
+      done(std::move(error));
+    });
+  }
+
+  // join all tasks and rethrow the first task failure if any
+  void wait() {
+    wait_noexcept();
+
+    if (m_error) {
+      std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+  }
+
+private:
+  void wait_noexcept() {
+    // help the pool while waiting so that nested groups can not starve it
+    while (m_pending != 0) {
+      if (!m_pool.run_pending()) {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_cv.wait_for(lock, std::chrono::milliseconds(1),
+                      [this] { return m_pending == 0; });
+      }
+    }
+
+    // synchronize with the last task still signaling completion
+    std::lock_guard<std::mutex> lock{m_mutex};
+  }
+};
+} // namespace pipet::helpers
@@ -17,6 +17,21 @@
 #include "utils.h"
 
 #include <type_traits>
+#include <utility>
+
+#if defined(__has_builtin)
+#if __has_builtin(__type_pack_element)
+#define PIPET_HAS_TYPE_PACK_ELEMENT 1
+#endif
+#endif
+
+#ifndef PIPET_HAS_TYPE_PACK_ELEMENT
+#define PIPET_HAS_TYPE_PACK_ELEMENT 0
+#endif
+
+#ifndef PIPET_FOLD_CHUNK_SIZE
+#define PIPET_FOLD_CHUNK_SIZE 32
+#endif
 
 namespace pipet::helpers {
 // generic typelist features
@@ -64,6 +79,38 @@ template <template <typename...> typename List> struct robust_front<List<>> {
 template <typename List>
 using robust_front_t = typename robust_front<List>::type;
 
+namespace detail {
+// indexed access through overload resolution (constant instantiation depth)
+template <std::size_t I, typename T> struct indexed { using type = T; };
+
+template <typename Is, typename... Items> struct indexer;
+
+template <std::size_t... Is, typename... Items>
+struct indexer<std::index_sequence<Is...>, Items...> : indexed<Is, Items>... {};
+
+template <std::size_t I, typename T>
+indexed<I, T> select_indexed(indexed<I, T> const &);
+} // namespace detail
+
+template <std::size_t I, typename List> struct at;
+
+template <std::size_t I, template <typename...> typename List,
+          typename... Items>
+struct at<I, List<Items...>> {
+  static_assert(I < sizeof...(Items), "[-][pipet] index out of range");
+
+#if PIPET_HAS_TYPE_PACK_ELEMENT
+  using type = __type_pack_element<I, Items...>;
+#else
+  using type = typename decltype(detail::select_indexed<I>(
+      std::declval<
+          detail::indexer<std::index_sequence_for<Items...>, Items...>>()))::
+      type;
+#endif
+};
+
+template <std::size_t I, typename List> using at_t = typename at<I, List>::type;
+
 template <typename List> struct pop_front;
 
 template <template <typename...> typename List, typename Head, typename... Tail>
@@ -88,78 +135,169 @@ struct push_front<Item, List<Items...>> {
 template <typename Item, typename List>
 using push_front_t = typename push_front<Item, List>::type;
 
-template <typename List> struct pop_back;
+template <typename Item, typename List> struct push_back;
 
-template <template <typename...> typename List, typename Head, typename... Tail>
-struct pop_back<List<Head, Tail...>> {
-  using type = push_front_t<Head, typename pop_back<List<Tail...>>::type>;
+template <typename Item, template <typename...> typename List,
+          typename... Items>
+struct push_back<Item, List<Items...>> {
+  using type = List<Items..., Item>;
 };
 
-template <template <typename...> typename List, typename Head>
-struct pop_back<List<Head>> {
-  using type = List<>;
+template <typename Item, typename List>
+using push_back_t = typename push_back<Item, List>::type;
+
+namespace detail {
+template <typename List, typename Is> struct take;
+
+template <template <typename...> typename List, typename... Items,
+          std::size_t... Is>
+struct take<List<Items...>, std::index_sequence<Is...>> {
+  using type = List<typename at<Is, List<Items...>>::type...>;
 };
 
-template <typename List> using pop_back_t = typename pop_back<List>::type;
+// algorithms below are right folds over the list items (no recursion on the
+// list), items are pushed in front of the ones already kept by the accumulator.
+// A fold expression covers at most PIPET_FOLD_CHUNK_SIZE items and chunks are
+// folded from the last one, so that no expression nests deeper than the
+// compiler limit (256 in clang) however long the list is
+template <typename T> struct fold_item {};
 
-namespace detail {
-template <typename Item, typename List, bool = is_empty_v<List>>
-struct push_back_impl;
+template <typename... Items> struct pack {};
 
-template <typename Item, typename List>
-struct push_back_impl<Item, List, false> {
-  using type =
-      push_front_t<front_t<List>,
-                   typename push_back_impl<Item, pop_front_t<List>>::type>;
+// kept items are the accumulator bases (inheritance-based set lookup)
+template <typename... Ts> struct unique_acc : fold_item<Ts>... {
+  template <template <typename...> typename List> using list = List<Ts...>;
 };
 
-template <typename Item, typename List>
-struct push_back_impl<Item, List, true> {
-  using type = push_front_t<Item, List>;
+template <typename T, typename... Ts>
+auto operator+(fold_item<T>, unique_acc<Ts...>)
+    -> std::conditional_t<std::is_base_of_v<fold_item<T>, unique_acc<Ts...>>,
+                          unique_acc<Ts...>, unique_acc<T, Ts...>>;
+
+template <template <typename> typename Pred, typename... Ts>
+struct filter_acc {
+  template <template <typename...> typename List> using list = List<Ts...>;
+};
+
+template <typename T, template <typename> typename Pred, typename... Ts>
+auto operator+(fold_item<T>, filter_acc<Pred, Ts...>)
+    -> std::conditional_t<Pred<T>::value, filter_acc<Pred, T, Ts...>,
+                          filter_acc<Pred, Ts...>>;
+
+template <typename Items, std::size_t Begin, typename Is> struct fold_chunk;
+
+template <typename... Items, std::size_t Begin, std::size_t... Is>
+struct fold_chunk<pack<Items...>, Begin, std::index_sequence<Is...>> {
+  template <typename Acc>
+  using apply = decltype((
+      fold_item<typename at<Begin + Is, pack<Items...>>::type>{} + ... +
+      Acc{}));
 };
+
+template <typename Items, std::size_t Begin, typename Is, typename Acc>
+auto operator+(fold_chunk<Items, Begin, Is>, Acc) ->
+    typename fold_chunk<Items, Begin, Is>::template apply<Acc>;
+
+template <typename Items,
+          typename Cs = std::make_index_sequence<
+              (size_v<Items> + PIPET_FOLD_CHUNK_SIZE - 1) /
+              PIPET_FOLD_CHUNK_SIZE>>
+struct chunked_fold;
+
+template <typename... Items, std::size_t... Cs>
+struct chunked_fold<pack<Items...>, std::index_sequence<Cs...>> {
+  static constexpr std::size_t chunk_size = PIPET_FOLD_CHUNK_SIZE;
+
+  static constexpr std::size_t chunk_length(std::size_t c) {
+    return sizeof...(Items) - c * chunk_size < chunk_size
+               ? sizeof...(Items) - c * chunk_size
+               : chunk_size;
+  }
+
+  template <typename Acc>
+  using apply = decltype((
+      fold_chunk<pack<Items...>, Cs * chunk_size,
+                 std::make_index_sequence<chunk_length(Cs)>>{} +
+      ... + Acc{}));
+};
+
+template <template <typename...> typename List, typename Acc,
+          typename... Items>
+using fold_t = typename chunked_fold<pack<Items...>>::template apply<
+    Acc>::template list<List>;
 } // namespace detail
 
-template <typename Item, typename List>
-struct push_back : detail::push_back_impl<Item, List> {};
+template <typename List> struct pop_back;
 
-template <typename Item, typename List>
-using push_back_t = typename push_back<Item, List>::type;
+template <template <typename...> typename List, typename Head, typename... Tail>
+struct pop_back<List<Head, Tail...>>
+    : detail::take<List<Head, Tail...>,
+                   std::make_index_sequence<sizeof...(Tail)>> {};
+
+template <template <typename...> typename List> struct pop_back<List<>> {
+  using type = List<>;
+};
+
+template <typename List> using pop_back_t = typename pop_back<List>::type;
+
+namespace detail {
+template <std::size_t N> constexpr std::size_t first_of(bool const *mask) {
+  std::size_t i = 0;
+  while (i < N && !mask[i]) {
+    ++i;
+  }
+  return i;
+}
+} // namespace detail
 
-template <typename Item, typename List> struct has {
+template <typename Item, typename List> struct has;
+
+template <typename Item, template <typename...> typename List,
+          typename... Items>
+struct has<Item, List<Items...>> {
+  static constexpr bool mask[sizeof...(Items) + 1] = {
+      std::is_same_v<Item, Items>...};
   static constexpr bool value =
-      !is_empty_v<List> && (std::is_same_v<Item, robust_front_t<List>> ||
-                            has<Item, pop_front_t<List>>::value);
+      detail::first_of<sizeof...(Items)>(mask) < sizeof...(Items);
 };
 
 template <typename Item, typename List>
 constexpr bool has_v = has<Item, List>::value;
 
-template <typename List> struct remove_dup;
+// index of the first occurrence of an item
+template <typename Item, typename List> struct index_of;
 
-template <template <typename...> typename List, typename Head, typename... Tail>
-struct remove_dup<List<Head, Tail...>> {
-  using type = std::conditional_t<
-      has_v<Head, List<Tail...>>, typename remove_dup<List<Tail...>>::type,
-      push_front_t<Head, typename remove_dup<List<Tail...>>::type>>;
-};
+template <typename Item, template <typename...> typename List,
+          typename... Items>
+struct index_of<Item, List<Items...>> {
+  static constexpr bool mask[sizeof...(Items) + 1] = {
+      std::is_same_v<Item, Items>...};
+  static constexpr std::size_t value =
+      detail::first_of<sizeof...(Items)>(mask);
 
-template <template <typename...> typename List, typename Head>
-struct remove_dup<List<Head>> {
-  using type = List<Head>;
+  static_assert(value < sizeof...(Items), "[-][pipet] type not found");
 };
 
-template <typename List> using remove_dup_t = typename remove_dup<List>::type;
+template <typename Item, typename List>
+constexpr std::size_t index_of_v = index_of<Item, List>::value;
 
-template <typename List1, typename List2, bool = is_empty_v<List2>>
-struct concat;
+// keep the last occurrence of each item
+template <typename List> struct remove_dup;
 
-template <typename List1, typename List2> struct concat<List1, List2, false> {
-  using type = push_front_t<front_t<List2>,
-                            typename concat<List1, pop_front_t<List2>>::type>;
+template <template <typename...> typename List, typename... Items>
+struct remove_dup<List<Items...>> {
+  using type = detail::fold_t<List, detail::unique_acc<>, Items...>;
 };
 
-template <typename List1, typename List2> struct concat<List1, List2, true> {
-  using type = List1;
+template <typename List> using remove_dup_t = typename remove_dup<List>::type;
+
+// concatenation of the items of List2 and List1 into List1
+template <typename List1, typename List2> struct concat;
+
+template <template <typename...> typename List1, typename... Items1,
+          template <typename...> typename List2, typename... Items2>
+struct concat<List1<Items1...>, List2<Items2...>> {
+  using type = List1<Items2..., Items1...>;
 };
 
 template <typename List1, typename List2>
@@ -168,14 +306,17 @@ using concat_t = typename concat<List1, List2>::type;
 template <typename List1, typename List2>
 using merge_t = remove_dup_t<concat_t<List1, List2>>;
 
-template <typename... Lists> struct concat_all;
+namespace detail {
+template <typename List> struct concat_term { using type = List; };
 
-template <typename L1, typename L2, typename... Ls>
-struct concat_all<L1, L2, Ls...> {
-  using type = concat_t<L1, typename concat_all<L2, Ls...>::type>;
-};
+template <typename List1, typename List2>
+auto operator+(concat_term<List1>, concat_term<List2>)
+    -> concat_term<concat_t<List1, List2>>;
+} // namespace detail
 
-template <typename L> struct concat_all<L> { using type = L; };
+template <typename... Lists> struct concat_all {
+  using type = typename decltype((detail::concat_term<Lists>{} + ...))::type;
+};
 
 template <typename... Lists>
 using concat_all_t = typename concat_all<Lists...>::type;
@@ -183,6 +324,82 @@ using concat_all_t = typename concat_all<Lists...>::type;
 template <typename... Lists>
 using merge_all_t = remove_dup_t<concat_all_t<Lists...>>;
 
+// apply a metafunction (F<T>::type) to each item
+template <template <typename> typename F, typename List> struct transform;
+
+template <template <typename> typename F,
+          template <typename...> typename List, typename... Items>
+struct transform<F, List<Items...>> {
+  using type = List<typename F<Items>::type...>;
+};
+
+template <template <typename> typename F, typename List>
+using transform_t = typename transform<F, List>::type;
+
+// keep the items satisfying a predicate (Pred<T>::value)
+template <template <typename> typename Pred, typename List> struct filter;
+
+template <template <typename> typename Pred,
+          template <typename...> typename List, typename... Items>
+struct filter<Pred, List<Items...>> {
+  using type = detail::fold_t<List, detail::filter_acc<Pred>, Items...>;
+};
+
+template <template <typename> typename Pred, typename List>
+using filter_t = typename filter<Pred, List>::type;
+
+namespace detail {
+// stable insertion sort of the item indices by key
+template <std::size_t N> struct selection {
+  std::size_t indices[N + 1]{};
+};
+
+template <std::size_t N, typename K>
+constexpr selection<N> sort_selection(K const *keys) {
+  selection<N> res{};
+  for (std::size_t i = 0; i < N; ++i) {
+    auto pos = i;
+    for (; pos > 0 && keys[i] < keys[res.indices[pos - 1]]; --pos) {
+      res.indices[pos] = res.indices[pos - 1];
+    }
+    res.indices[pos] = i;
+  }
+  return res;
+}
+
+template <typename K, K... Keys> struct sort_selector {
+  static constexpr K keys[sizeof...(Keys) + 1] = {Keys...};
+  static constexpr auto value = sort_selection<sizeof...(Keys)>(keys);
+};
+
+template <typename List, typename Sel,
+          typename Is = std::make_index_sequence<size_v<List>>>
+struct apply_selection;
+
+template <template <typename...> typename List, typename... Items,
+          typename Sel, std::size_t... Is>
+struct apply_selection<List<Items...>, Sel, std::index_sequence<Is...>> {
+  using type =
+      List<typename at<Sel::value.indices[Is], List<Items...>>::type...>;
+};
+} // namespace detail
+
+// stable sort of the items by ascending key (Key<T>::value)
+template <template <typename> typename Key, typename List> struct sort;
+
+template <template <typename> typename Key,
+          template <typename...> typename List, typename... Items>
+struct sort<Key, List<Items...>>
+    : detail::apply_selection<
+          List<Items...>,
+          detail::sort_selector<
+              std::common_type_t<
+                  std::remove_cv_t<decltype(Key<Items>::value)>..., int>,
+              Key<Items>::value...>> {};
+
+template <template <typename> typename Key, typename List>
+using sort_t = typename sort<Key, List>::type;
+
 // rebind
 template <template <typename...> typename TList, typename SList> struct rebind;
 
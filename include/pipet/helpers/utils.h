@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <type_traits>
@@ -41,4 +42,14 @@ template <typename S, S val, typename T> struct is_unsigned_compatible {
                 "[-][pipet] bad usage");
   static constexpr bool value = (val <= (std::numeric_limits<T>::max)());
 };
+
+// number of set flags of a mask, reduces a long pack without nesting a fold
+// expression per item (clang caps the nesting at 256)
+constexpr std::size_t count_set(bool const *mask, std::size_t n) {
+  std::size_t res = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    res += mask[i];
+  }
+  return res;
+}
 } // namespace pipet::helpers
\ No newline at end of file
@@ -0,0 +1,162 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "filter.h"
+#include "helpers/typelist.h"
+#include "helpers/utils.h"
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace pipet {
+namespace detail {
+// pipe instance details
+
+template <typename F> struct is_branches : std::false_type {};
+
+template <typename... Ps>
+struct is_branches<branches<Ps...>> : std::true_type {};
+
+template <typename F> constexpr bool is_branches_v = is_branches<F>::value;
+
+template <typename... Ps>
+using branches_arg_t = helpers::front_t<
+    helpers::merge_all_t<typename traits::filter_traits<Ps>::args_type...>>;
+
+// I/O compatibility of two adjacent filters of an instance
+template <typename F, typename R> struct instance_io_checker {
+  static constexpr bool value = concept ::io_compatible<F, R>();
+};
+
+template <typename F, typename... Ps>
+struct instance_io_checker<F, branches<Ps...>> {
+  static constexpr bool value =
+      std::is_convertible_v<typename traits::filter_traits<F>::ret_type,
+                            branches_arg_t<Ps...>>;
+};
+
+template <typename... Ps, typename R>
+struct instance_io_checker<branches<Ps...>, R> {
+  static constexpr bool value = concept ::io_compatible_x<R, Ps...>();
+};
+
+template <typename List, std::size_t... Is>
+constexpr bool instance_io_compatible(std::index_sequence<Is...>) {
+  return (instance_io_checker<std::tuple_element_t<Is, List>,
+                              std::tuple_element_t<Is + 1, List>>::value &&
+          ...);
+}
+} // namespace detail
+
+// pipe owning one instance of each filter, filters may hold a state built once
+// (non-static process/reverse) or be stateless (static process/reverse)
+template <typename... Fs> class pipe_instance {
+  static_assert(sizeof...(Fs) > 0, "[-][pipet] empty pipe instance");
+  static_assert(detail::instance_io_compatible<std::tuple<Fs...>>(
+                    std::make_index_sequence<sizeof...(Fs) - 1>{}),
+                "[-][pipet] requirement not met");
+  static_assert(!detail::is_branches_v<
+                    std::tuple_element_t<sizeof...(Fs) - 1, std::tuple<Fs...>>>,
+                "[-][pipet] branches must be followed by a multi-args filter");
+
+  using filters_type = std::tuple<Fs...>;
+  static constexpr std::size_t size = sizeof...(Fs);
+
+  filters_type m_filters;
+
+  template <std::size_t I>
+  using filter_t = std::tuple_element_t<I, filters_type>;
+
+  // apply filters [I, size) on the value produced by th
+  template <std::size_t I, typename Self, typename Th>
+  static constexpr auto run(Self &self, Th const &th) {
+    if constexpr (I == size) {
+      return th();
+    } else if constexpr (detail::is_branches_v<filter_t<I>>) {
+      return run<I + 2>(self, [&]() {
+        return fan_out<I + 1>(self, th(), filter_t<I>{});
+      });
+    } else {
+      return run<I + 1>(
+          self, [&]() { return std::get<I>(self.m_filters).process(th()); });
+    }
+  }
+
+  template <std::size_t I, typename Self, typename Arg, typename... Ps>
+  static constexpr auto fan_out(Self &self, Arg const &arg, branches<Ps...>) {
+    return std::get<I>(self.m_filters).process(Ps::process(arg)...);
+  }
+
+  // apply filters [0, I) in reverse order on the value produced by th
+  template <std::size_t I, typename Self, typename Th>
+  static constexpr auto run_reverse(Self &self, Th const &th) {
+    if constexpr (I == 0) {
+      return th();
+    } else {
+      return run_reverse<I - 1>(self, [&]() {
+        return std::get<I - 1>(self.m_filters).reverse(th());
+      });
+    }
+  }
+
+  template <typename Self, typename... Args>
+  static constexpr auto process_impl(Self &self, Args &&... args) {
+    if constexpr (detail::is_branches_v<filter_t<0>>) {
+      return run<2>(self, [&]() {
+        return fan_out<1>(self, std::as_const(args)..., filter_t<0>{});
+      });
+    } else {
+      return run<1>(self, [&]() {
+        return std::get<0>(self.m_filters).process(std::forward<Args>(args)...);
+      });
+    }
+  }
+
+public:
+  constexpr pipe_instance() = default;
+
+  // filter setup is done once, at instance construction
+  constexpr explicit pipe_instance(Fs... filters)
+      : m_filters{std::move(filters)...} {}
+
+  template <std::size_t I> constexpr auto &get() {
+    return std::get<I>(m_filters);
+  }
+
+  template <std::size_t I> constexpr auto const &get() const {
+    return std::get<I>(m_filters);
+  }
+
+  template <typename... Args> constexpr auto process(Args &&... args) {
+    return process_impl(*this, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args> constexpr auto process(Args &&... args) const {
+    return process_impl(*this, std::forward<Args>(args)...);
+  }
+
+  template <typename Arg> constexpr auto reverse(Arg &&arg) {
+    return run_reverse<size>(
+        *this, [&]() -> decltype(auto) { return std::forward<Arg>(arg); });
+  }
+
+  template <typename Arg> constexpr auto reverse(Arg &&arg) const {
+    return run_reverse<size>(
+        *this, [&]() -> decltype(auto) { return std::forward<Arg>(arg); });
+  }
+};
+} // namespace pipet
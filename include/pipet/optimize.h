@@ -0,0 +1,240 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "filter.h"
+#include "helpers/reflect.h"
+#include "helpers/typelist.h"
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace pipet {
+// Filters taking part in the pipe optimization pass declare:
+//  - using inverse_type = G;          G undoes the filter (F, G removed, the
+//                                     reverse order G, F is kept)
+//  - using commute_group = Tag;       filters of a group commute
+//  - static constexpr std::size_t cost = N;   relative cost (default 1)
+// and traits::compose<F, G> is specialized for the filters merged into a
+// single one (type = placeholders::self when they cancel out)
+
+namespace traits {
+template <typename F, typename G> struct compose {};
+} // namespace traits
+
+// filter undoing a reversible filter F (process and reverse swapped), the
+// pair F, inverse<F> is removed (not inverse<F>, F: reverse is only required
+// to undo process)
+template <typename F> struct inverse {
+  using arg_type = typename traits::filter_traits<F>::ret_type;
+  using ret_type = std::decay_t<
+      helpers::front_t<typename traits::filter_traits<F>::args_type>>;
+
+  static constexpr ret_type process(arg_type arg) {
+    return F::reverse(std::move(arg));
+  }
+
+  static constexpr arg_type reverse(ret_type arg) {
+    return F::process(std::move(arg));
+  }
+};
+
+namespace detail {
+// optimization pass details: stages are pushed one by one on a stack, the
+// pushed stage is checked against the top of the stack, a cancelled pair is
+// popped, a composed pair is replaced by its composition and a cheaper
+// commuting stage is moved below the top (the result being pushed again, so
+// that rewrites cascade)
+
+template <typename F> using inverse_type_t = typename F::inverse_type;
+
+template <typename F> using commute_group_t = typename F::commute_group;
+
+template <typename F> using cost_t = decltype(F::cost);
+
+template <typename F, typename G>
+using compose_type_t = typename traits::compose<F, G>::type;
+
+// G undoes F (declared by F or G being the inverse adaptor of F)
+template <typename F, typename G> constexpr bool is_undone_by() {
+  if constexpr (std::is_same_v<G, inverse<F>>) {
+    return true;
+  } else if constexpr (helpers::is_detected_v<inverse_type_t, F>) {
+    return std::is_same_v<inverse_type_t<F>, G>;
+  } else {
+    return false;
+  }
+}
+
+template <typename F> constexpr std::size_t filter_cost() {
+  if constexpr (helpers::is_detected_v<cost_t, F>) {
+    return F::cost;
+  } else {
+    return 1;
+  }
+}
+
+template <typename F, typename G> constexpr bool is_commuting() {
+  if constexpr (helpers::is_detected_v<commute_group_t, F> &&
+                helpers::is_detected_v<commute_group_t, G>) {
+    return std::is_same_v<commute_group_t<F>, commute_group_t<G>>;
+  } else {
+    return false;
+  }
+}
+
+// branches (and the filter consuming them) are left untouched
+template <typename F> struct is_plain_stage : std::true_type {};
+
+template <typename... Ps>
+struct is_plain_stage<branches<Ps...>> : std::false_type {};
+
+template <typename... Ps>
+struct is_plain_stage<par_branches<Ps...>> : std::false_type {};
+
+enum class stage_action { push, cancel, compose, swap };
+
+template <typename F, typename G> constexpr stage_action select_action() {
+  if constexpr (!is_plain_stage<F>::value || !is_plain_stage<G>::value) {
+    return stage_action::push;
+  } else if constexpr (is_undone_by<F, G>()) {
+    return stage_action::cancel;
+  } else if constexpr (helpers::is_detected_v<compose_type_t, F, G>) {
+    return std::is_same_v<compose_type_t<F, G>, placeholders::self>
+               ? stage_action::cancel
+               : stage_action::compose;
+  } else if constexpr (is_commuting<F, G>() &&
+                       filter_cost<G>() < filter_cost<F>()) {
+    return stage_action::swap;
+  } else {
+    return stage_action::push;
+  }
+}
+
+// kept stages, top of the stack first (push and pop without walking it)
+template <typename... Fs> struct stage_stack {};
+
+template <typename Stack, typename G> struct push_stage;
+
+template <typename Stack, typename G>
+using push_stage_t = typename push_stage<Stack, G>::type;
+
+template <typename Stack, typename G, stage_action A> struct apply_action {
+  using type = helpers::push_front_t<G, Stack>;
+};
+
+template <typename F, typename... Fs, typename G>
+struct apply_action<stage_stack<F, Fs...>, G, stage_action::cancel> {
+  using type = stage_stack<Fs...>;
+};
+
+template <typename F, typename... Fs, typename G>
+struct apply_action<stage_stack<F, Fs...>, G, stage_action::compose> {
+  using type = push_stage_t<stage_stack<Fs...>, compose_type_t<F, G>>;
+};
+
+template <typename F, typename... Fs, typename G>
+struct apply_action<stage_stack<F, Fs...>, G, stage_action::swap> {
+  using type = push_stage_t<push_stage_t<stage_stack<Fs...>, G>, F>;
+};
+
+template <typename G> struct push_stage<stage_stack<>, G> {
+  using type = stage_stack<G>;
+};
+
+template <typename F, typename... Fs, typename G>
+struct push_stage<stage_stack<F, Fs...>, G>
+    : apply_action<stage_stack<F, Fs...>, G, select_action<F, G>()> {};
+
+// stages are pushed by a chunked right fold over the reversed pipe (first
+// stage pushed first)
+template <typename G, typename... Fs>
+auto operator+(helpers::detail::fold_item<G>, stage_stack<Fs...>)
+    -> push_stage_t<stage_stack<Fs...>, G>;
+
+template <template <typename...> typename To, typename List,
+          typename Is = std::make_index_sequence<helpers::size_v<List>>>
+struct reverse_list;
+
+template <template <typename...> typename To,
+          template <typename...> typename List, typename... Fs,
+          std::size_t... Is>
+struct reverse_list<To, List<Fs...>, std::index_sequence<Is...>> {
+  using type = To<helpers::at_t<sizeof...(Fs) - 1 - Is, List<Fs...>>...>;
+};
+
+template <template <typename...> typename To, typename List>
+using reverse_list_t = typename reverse_list<To, List>::type;
+
+// pass through the value of a fully cancelled pipe
+template <typename T> struct identity {
+  static constexpr T process(T arg) { return arg; }
+  static constexpr T reverse(T arg) { return arg; }
+};
+
+template <typename F, typename List> struct non_empty_pipe {
+  using type = List;
+};
+
+template <typename F> struct non_empty_pipe<F, helpers::typelist<>> {
+  using type = helpers::typelist<identity<std::decay_t<
+      helpers::front_t<typename traits::filter_traits<F>::args_type>>>>;
+};
+
+// a pipe is only rewritten when one of its filters opts in (inverse_type,
+// commute_group, inverse adaptor or a composition with the next filter)
+template <typename F> struct is_inverse_adaptor : std::false_type {};
+
+template <typename F> struct is_inverse_adaptor<inverse<F>> : std::true_type {};
+
+template <typename F> constexpr bool declares_rewrite() {
+  return helpers::is_detected_v<inverse_type_t, F> ||
+         helpers::is_detected_v<commute_group_t, F> ||
+         is_inverse_adaptor<F>::value;
+}
+
+struct end_stage {};
+
+template <typename Fs, typename Nexts> struct has_rewrite;
+
+template <typename... Fs, typename... Nexts>
+struct has_rewrite<helpers::typelist<Fs...>, helpers::typelist<Nexts...>> {
+  static constexpr bool mask[2 * sizeof...(Fs)] = {
+      declares_rewrite<Fs>()...,
+      helpers::is_detected_v<compose_type_t, Fs, Nexts>...};
+  static constexpr bool value = helpers::count_set(mask, 2 * sizeof...(Fs)) > 0;
+};
+
+template <bool Rewrite, typename F, typename... R> struct optimize {
+  using type = helpers::typelist<F, R...>;
+};
+
+template <typename F, typename... R> struct optimize<true, F, R...> {
+  using stack_type = typename helpers::detail::chunked_fold<
+      reverse_list_t<helpers::detail::pack, helpers::typelist<F, R...>>>::
+      template apply<stage_stack<>>;
+  using type = typename non_empty_pipe<
+      F, reverse_list_t<helpers::typelist, stack_type>>::type;
+};
+
+// filters of an optimized pipe
+template <typename F, typename... R>
+using optimize_t =
+    typename optimize<has_rewrite<helpers::typelist<F, R...>,
+                                  helpers::typelist<R..., end_stage>>::value,
+                      F, R...>::type;
+} // namespace detail
+} // namespace pipet
\ No newline at end of file
@@ -15,115 +15,942 @@
 #pragma once
 
 #include "filter.h"
+#include "helpers/span.h"
+#include "helpers/thread_pool.h"
 #include "helpers/typelist.h"
 #include "helpers/utils.h"
+#include "optimize.h"
 
+#include <array>
+#include <optional>
+#include <tuple>
 #include <type_traits>
 
+#ifndef PIPET_BATCH_BLOCK_BYTES
+#define PIPET_BATCH_BLOCK_BYTES 4096
+#endif
+
+#ifndef PIPET_CHAIN_CHUNK_SIZE
+#define PIPET_CHAIN_CHUNK_SIZE 32
+#endif
+
 namespace pipet {
 
+template <typename... Args> struct pipe;
+
 namespace detail {
-template <typename F, typename R, typename T> struct regular_element_impl;
+// batch execution details
 
-template <typename F, typename R>
-struct regular_element_impl<F, R, filter_gen> {
-  static constexpr auto process() { return R::process(F::process()); }
+// number of intermediate values processed by a stage before handing
+// the block over to the next one (sized to stay in L1)
+template <typename T>
+constexpr std::size_t batch_block_size =
+    (sizeof(T) < PIPET_BATCH_BLOCK_BYTES) ? PIPET_BATCH_BLOCK_BYTES / sizeof(T)
+                                          : 1;
+
+template <typename F, typename In, typename Out>
+using process_batch_t = decltype(F::process_batch(
+    std::declval<helpers::span<In const>>(), std::declval<helpers::span<Out>>()));
+
+template <typename F, typename In, typename Out>
+using reverse_batch_t = decltype(F::reverse_batch(
+    std::declval<helpers::span<In const>>(), std::declval<helpers::span<Out>>()));
+
+// run one filter over a block, using its own batch routine if any
+template <typename F, typename In, typename Out>
+constexpr void filter_process_batch(helpers::span<In const> in,
+                                    helpers::span<Out> out) {
+  if constexpr (helpers::is_detected_v<process_batch_t, F, In, Out>) {
+    F::process_batch(in, out);
+  } else {
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      out[i] = F::process(in[i]);
+    }
+  }
+}
+
+template <typename F, typename In, typename Out>
+constexpr void filter_reverse_batch(helpers::span<In const> in,
+                                    helpers::span<Out> out) {
+  if constexpr (helpers::is_detected_v<reverse_batch_t, F, In, Out>) {
+    F::reverse_batch(in, out);
+  } else {
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      out[i] = F::reverse(in[i]);
+    }
+  }
+}
+
+// run first then next block by block through an intermediate buffer
+template <typename Mid, typename In, typename Out, typename First,
+          typename Next, typename Single>
+constexpr void chain_batch(helpers::span<In const> in, helpers::span<Out> out,
+                           First first, Next next, Single single) {
+  if constexpr (std::is_default_constructible_v<Mid>) {
+    std::array<Mid, batch_block_size<Mid>> block{};
+
+    for (std::size_t off = 0; off < in.size(); off += block.size()) {
+      auto const n =
+          (in.size() - off < block.size()) ? in.size() - off : block.size();
+      first(in.subspan(off, n), helpers::span<Mid>{block.data(), n});
+      next(helpers::span<Mid const>{block.data(), n}, out.subspan(off, n));
+    }
+  } else {
+    // no intermediate buffer possible, fallback to value per value
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      out[i] = single(in[i]);
+    }
+  }
+}
+
+// deferred evaluation details: a stage output is only produced when the next
+// filter call needs it, so that it is handed over as a prvalue (no copy/move
+// between stages)
+
+template <typename F, typename Th>
+using process_deferred_t =
+    decltype(F::process_deferred(std::declval<Th const &>()));
+
+template <typename F, typename Th>
+using reverse_deferred_t =
+    decltype(F::reverse_deferred(std::declval<Th const &>()));
+
+template <typename F, typename Th>
+constexpr auto invoke_process(Th const &th) {
+  // nested pipes are fed without materializing their input
+  if constexpr (helpers::is_detected_v<process_deferred_t, F, Th>) {
+    return F::process_deferred(th);
+  } else {
+    return F::process(th());
+  }
+}
+
+template <typename F, typename Th>
+constexpr auto invoke_reverse(Th const &th) {
+  if constexpr (helpers::is_detected_v<reverse_deferred_t, F, Th>) {
+    return F::reverse_deferred(th);
+  } else {
+    return F::reverse(th());
+  }
+}
+
+// reverse entry keeps the parameter type of the last filter reverse function
+template <typename F>
+using reverse_params_t = decltype(helpers::function_params(&F::reverse));
+
+template <typename F, bool = helpers::is_detected_v<reverse_params_t, F>>
+struct reverse_param {
+  using type = typename traits::filter_traits<F>::ret_type;
+};
+
+template <typename F> struct reverse_param<F, true> {
+  using type = helpers::front_t<reverse_params_t<F>>;
 };
 
-template <typename F, typename R, typename Args>
-struct regular_element_impl_varargs;
+template <typename F>
+using reverse_param_t = typename reverse_param<F>::type;
+
+// fan-out details: a branch point is fused with the multi-args filter
+// consuming its results into a single stage
+
+template <typename F> struct is_fan_out : std::false_type {};
+
+template <typename... Ps>
+struct is_fan_out<branches<Ps...>> : std::true_type {};
 
-template <typename F, typename R, template <typename...> typename List,
-          typename... Args>
-struct regular_element_impl_varargs<F, R, List<Args...>>
-    : helpers::requires_v<concept ::io_compatible<F, R>()> {
-  static constexpr auto process(Args... args) {
-    return R::process(F::process(std::move(args)...));
+template <typename... Ps>
+struct is_fan_out<par_branches<Ps...>> : std::true_type {};
+
+template <typename F> constexpr bool is_fan_out_v = is_fan_out<F>::value;
+
+// shared branches details: a branch is a list of filters (a pipe without
+// fan-out is flattened), the filter heading several lists is evaluated once
+// on the shared value, so duplicate branches and common prefixes of branches
+// are computed once
+
+template <typename P> struct branch_filters {
+  using type = helpers::typelist<P>;
+};
+
+template <> struct branch_filters<placeholders::self> {
+  using type = helpers::typelist<>;
+};
+
+template <typename P, typename Fs> struct pipe_branch_filters;
+
+template <typename P, typename... Fs>
+struct pipe_branch_filters<P, helpers::typelist<Fs...>> {
+  static constexpr bool fan_outs[sizeof...(Fs) + 1] = {is_fan_out_v<Fs>...};
+  using type =
+      std::conditional_t<helpers::count_set(fan_outs, sizeof...(Fs)) != 0,
+                         helpers::typelist<P>, helpers::typelist<Fs...>>;
+};
+
+// filters of the optimized pipe
+template <typename... Fs>
+struct branch_filters<pipe<Fs...>>
+    : pipe_branch_filters<pipe<Fs...>, typename pipe<Fs...>::filters_type> {};
+
+template <typename P>
+using branch_filters_t = typename branch_filters<P>::type;
+
+// head filter of a list, nonsuch for the lists already evaluated
+template <typename List> using branch_head_t = helpers::robust_front_t<List>;
+
+// lists grouped by head filter
+template <typename... Lists> struct branch_groups {
+  using heads_type =
+      helpers::remove_dup_t<helpers::typelist<branch_head_t<Lists>...>>;
+
+  static constexpr std::size_t count = helpers::size_v<heads_type>;
+
+  static constexpr std::size_t group[] = {
+      helpers::index_of_v<branch_head_t<Lists>, heads_type>...};
+
+  static constexpr bool is_leaf(std::size_t g) {
+    return g == helpers::index_of_v<helpers::nonsuch,
+                                    helpers::push_back_t<helpers::nonsuch,
+                                                         heads_type>>;
+  }
+
+  static constexpr std::size_t size(std::size_t g) {
+    std::size_t n = 0;
+    for (auto i : group) {
+      n += (i == g);
+    }
+    return n;
+  }
+
+  // index of the k-th list of group g
+  static constexpr std::size_t member(std::size_t g, std::size_t k) {
+    std::size_t i = 0;
+    for (; group[i] != g || k; ++i) {
+      k -= (group[i] == g);
+    }
+    return i;
+  }
+
+  // position of list i in its group
+  static constexpr std::size_t rank(std::size_t i) {
+    std::size_t n = 0;
+    for (std::size_t j = 0; j < i; ++j) {
+      n += (group[j] == group[i]);
+    }
+    return n;
+  }
+
+  // a filter is shared by several lists
+  static constexpr bool is_shared() {
+    for (std::size_t g = 0; g < count; ++g) {
+      if (!is_leaf(g) && size(g) > 1) {
+        return true;
+      }
+    }
+    return false;
   }
 };
 
-template <typename F, typename R>
-struct regular_element_impl<F, R, filter_proc>
-    : regular_element_impl_varargs<
-          F, R, typename traits::filter_traits<F>::args_type> {};
+template <typename... Lists> struct shared_branches {
+  using groups = branch_groups<Lists...>;
+  using lists_type = helpers::typelist<Lists...>;
+
+  template <std::size_t G, std::size_t... Ks>
+  static auto group_node(std::index_sequence<Ks...>)
+      -> shared_branches<helpers::pop_front_t<
+          helpers::at_t<groups::member(G, Ks), lists_type>>...>;
+
+  // lists of group G without their head
+  template <std::size_t G>
+  using group_node_t = decltype(
+      group_node<G>(std::make_index_sequence<groups::size(G)>{}));
+
+  // results of the lists in order, the value is moved when it has a single
+  // consumer and copied otherwise
+  template <typename T> static constexpr auto eval(T &&v) {
+    return eval_groups(std::forward<T>(v),
+                       std::make_index_sequence<groups::count>{},
+                       std::index_sequence_for<Lists...>{});
+  }
 
-template <typename R, typename... Ps>
-struct regular_element_impl<branches<Ps...>, R, filter_proc>
+private:
+  static constexpr bool is_single_consumer =
+      groups::count == 1 && sizeof...(Lists) == 1;
+
+  template <std::size_t G, typename T>
+  static constexpr auto eval_group(T &&v) {
+    using head_type = helpers::at_t<G, typename groups::heads_type>;
+
+    if constexpr (groups::is_leaf(G)) {
+      return std::tuple<>{};
+    } else if constexpr (groups::count == 1) {
+      return group_node_t<G>::eval(head_type::process(std::forward<T>(v)));
+    } else {
+      return group_node_t<G>::eval(head_type::process(v));
+    }
+  }
+
+  template <std::size_t I, typename T, typename Subs>
+  static constexpr auto fetch(T &&v, Subs &subs) {
+    if constexpr (!groups::is_leaf(groups::group[I])) {
+      return std::get<groups::rank(I)>(
+          std::move(std::get<groups::group[I]>(subs)));
+    } else if constexpr (is_single_consumer) {
+      return std::decay_t<T>(std::forward<T>(v));
+    } else {
+      return std::decay_t<T>(v);
+    }
+  }
+
+  template <typename T, std::size_t... Gs, std::size_t... Is>
+  static constexpr auto eval_groups(T &&v, std::index_sequence<Gs...>,
+                                    std::index_sequence<Is...>) {
+    // groups are evaluated in order (braced initialization)
+    std::tuple<decltype(eval_group<Gs>(std::forward<T>(v)))...> subs{
+        eval_group<Gs>(std::forward<T>(v))...};
+
+    return std::tuple<decltype(fetch<Is>(std::forward<T>(v), subs))...>{
+        fetch<Is>(std::forward<T>(v), subs)...};
+  }
+};
+
+template <typename... Ps>
+using shared_branches_t = shared_branches<branch_filters_t<Ps>...>;
+
+template <typename B, typename R> struct fan_out_stage;
+
+template <typename... Ps, typename R>
+struct fan_out_stage<branches<Ps...>, R>
     : helpers::requires_v<concept ::io_compatible_x<R, Ps...>()> {
 
   using f_arg_type = helpers::front_t<
       helpers::merge_all_t<typename traits::filter_traits<Ps>::args_type...>>;
+  using r_ret_type = typename traits::filter_traits<R>::ret_type;
 
   static constexpr auto process(f_arg_type arg) {
-    return R::process(Ps::process(arg)...);
+    if constexpr (shared_branches_t<Ps...>::groups::is_shared()) {
+      return std::apply(
+          [](auto &&... res) {
+            return R::process(std::forward<decltype(res)>(res)...);
+          },
+          shared_branches_t<Ps...>::eval(arg));
+    } else {
+      return R::process(Ps::process(arg)...);
+    }
+  }
+
+  // fan-out can not be done block-wise, fallback to value per value
+  static constexpr void process_batch(helpers::span<f_arg_type const> in,
+                                      helpers::span<r_ret_type> out) {
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      out[i] = process(in[i]);
+    }
   }
 };
 
-template <typename F, typename R>
-struct regular_element_impl<F, R, filter_rev_proc>
-    : regular_element_impl<F, R, filter_proc> {
+// parallel branches details
+
+// branches cheap enough to be always run on the calling thread
+template <typename P>
+constexpr bool is_inline_branch_v = std::is_same_v<P, placeholders::self>;
+
+template <typename... Ps, typename R>
+struct fan_out_stage<par_branches<Ps...>, R>
+    : helpers::requires_v<concept ::io_compatible_x<R, Ps...>()> {
+
+  using f_arg_type = helpers::front_t<
+      helpers::merge_all_t<typename traits::filter_traits<Ps>::args_type...>>;
   using r_ret_type = typename traits::filter_traits<R>::ret_type;
 
-  static constexpr auto reverse(r_ret_type arg) {
-    return F::reverse(R::reverse(std::move(arg)));
+  static auto process(f_arg_type arg) {
+    if constexpr (task_count() <= 1) {
+      return R::process(Ps::process(arg)...);
+    } else {
+      return process_par(arg, std::index_sequence_for<Ps...>{});
+    }
+  }
+
+  static void process_batch(helpers::span<f_arg_type const> in,
+                            helpers::span<r_ret_type> out) {
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      out[i] = process(in[i]);
+    }
+  }
+
+private:
+  template <typename P>
+  using branch_ret_t =
+      decltype(P::process(std::declval<f_arg_type const &>()));
+
+  using results_type = std::tuple<std::optional<branch_ret_t<Ps>>...>;
+
+  static constexpr std::size_t task_count() {
+    return (std::size_t{0} + ... + !is_inline_branch_v<Ps>);
+  }
+
+  // first heavy branch, kept for the calling thread
+  static constexpr std::size_t local_task() {
+    constexpr bool inlined[] = {is_inline_branch_v<Ps>...};
+    std::size_t i = 0;
+    while (inlined[i]) {
+      ++i;
+    }
+    return i;
+  }
+
+  template <std::size_t I, typename P>
+  static void spawn(helpers::task_group &group, results_type &results,
+                    f_arg_type const &arg) {
+    if constexpr (!is_inline_branch_v<P> && I != local_task()) {
+      group.run([&results, &arg] {
+        std::get<I>(results).emplace(P::process(arg));
+      });
+    }
+  }
+
+  template <std::size_t I, typename P>
+  static decltype(auto) fetch(results_type &results, f_arg_type const &arg) {
+    if constexpr (is_inline_branch_v<P>) {
+      return P::process(arg);
+    } else {
+      return std::move(*std::get<I>(results));
+    }
+  }
+
+  template <std::size_t... Is>
+  static auto process_par(f_arg_type const &arg, std::index_sequence<Is...>) {
+    results_type results;
+    {
+      helpers::task_group group;
+      (spawn<Is, Ps>(group, results, arg), ...);
+
+      using local_type = std::tuple_element_t<local_task(), std::tuple<Ps...>>;
+      std::get<local_task()>(results).emplace(local_type::process(arg));
+
+      group.wait();
+    }
+
+    return R::process(fetch<Is, Ps>(results, arg)...);
   }
 };
 
-template <typename F, typename T> struct end_element_impl;
+// flat chain details: a pipe is a flat list of stages reached by index,
+// consecutive stages are chained through prvalues by chunks of
+// PIPET_CHAIN_CHUNK_SIZE and chunks are chained by a fold expression, so that
+// instantiation depth does not grow with the pipe length (a value is moved
+// once between two chunks)
+
+template <typename F, typename Th> struct deferred_process {
+  Th const &m_th;
 
-template <typename F> struct end_element_impl<F, filter_gen> {
-  static constexpr auto process() { return F::process(); }
+  constexpr auto operator()() const { return invoke_process<F>(m_th); }
 };
 
-template <typename F, typename Args> struct end_element_impl_varargs;
+template <typename F, typename Th> struct deferred_reverse {
+  Th const &m_th;
+
+  constexpr auto operator()() const { return invoke_reverse<F>(m_th); }
+};
+
+template <typename F, typename Th>
+constexpr auto defer_process(Th const &th) {
+  return deferred_process<F, Th>{th};
+}
+
+template <typename F, typename Th>
+constexpr auto defer_reverse(Th const &th) {
+  return deferred_reverse<F, Th>{th};
+}
+
+// slot left empty: end of chain or fan-out (applied with its consumer)
+struct no_stage;
+
+template <typename Prev, typename F, bool = is_fan_out_v<Prev>,
+          bool = is_fan_out_v<F> || std::is_void_v<F>>
+struct stage_selector {
+  using type = F;
+};
+
+template <typename Prev, typename F, bool P>
+struct stage_selector<Prev, F, P, true> {
+  using type = no_stage;
+};
+
+template <typename Prev, typename F>
+struct stage_selector<Prev, F, true, false> {
+  using type = fan_out_stage<Prev, F>;
+};
+
+template <typename... Ss> struct stage_chain;
+
+// stage slots of filters Fs knowing the filter preceding each of them
+template <typename Prevs, typename Fs> struct make_stage_chain;
+
+template <typename... Prevs, typename... Fs>
+struct make_stage_chain<helpers::typelist<Prevs...>, helpers::typelist<Fs...>> {
+  using type = stage_chain<typename stage_selector<Prevs, Fs>::type...>;
+};
+
+template <typename Prevs, typename Fs>
+using make_stage_chain_t = typename make_stage_chain<Prevs, Fs>::type;
+
+template <typename List, std::size_t Lo, typename Is> struct slice;
+
+template <typename List, std::size_t Lo, std::size_t... Is>
+struct slice<List, Lo, std::index_sequence<Is...>> {
+  using type = stage_chain<helpers::at_t<Lo + Is, List>...>;
+};
 
-template <typename F, template <typename...> typename List, typename... Args>
-struct end_element_impl_varargs<F, List<Args...>>
-    : helpers::requires_v<concept ::check_args<F, Args...>()> {
-  static constexpr auto process(Args... args) {
-    return F::process(std::move(args)...);
+template <typename Seg> struct reversed {};
+
+template <typename T, typename... Ss>
+constexpr auto operator|(T &&v, stage_chain<Ss...>) {
+  return stage_chain<Ss...>::template run_from<0>(
+      [&]() -> decltype(auto) { return std::forward<T>(v); });
+}
+
+template <typename T, typename... Ss>
+constexpr auto operator|(T &&v, reversed<stage_chain<Ss...>>) {
+  return stage_chain<Ss...>::template run_reverse_from<sizeof...(Ss)>(
+      [&]() -> decltype(auto) { return std::forward<T>(v); });
+}
+
+template <typename... Ss> struct stage_chain {
+  using stages_type = helpers::typelist<Ss...>;
+  static constexpr std::size_t size = sizeof...(Ss);
+  static constexpr std::size_t chunk_size = PIPET_CHAIN_CHUNK_SIZE;
+
+  static_assert(chunk_size > 0, "[-][pipet] chain chunk size too small");
+
+  template <std::size_t I> using stage_t = helpers::at_t<I, stages_type>;
+
+  template <std::size_t I>
+  static constexpr bool is_empty_v = std::is_same_v<stage_t<I>, no_stage>;
+
+  static constexpr bool stage_mask[sizeof...(Ss) + 1] = {
+      !std::is_same_v<Ss, no_stage>...};
+  static constexpr std::size_t stage_count =
+      helpers::count_set(stage_mask, sizeof...(Ss));
+
+  // empty slots are never adjacent
+  template <std::size_t I>
+  static constexpr std::size_t first_stage = is_empty_v<I> ? I + 1 : I;
+
+  template <std::size_t I>
+  using stage_arg_t = helpers::front_t<
+      typename traits::filter_traits<stage_t<first_stage<I>>>::args_type>;
+
+  // stage producing the chain output (lazy, a chain may be empty)
+  template <std::size_t N = size>
+  using last_stage_t = stage_t<is_empty_v<N - 1> ? N - 2 : N - 1>;
+
+  template <std::size_t N = size>
+  using ret_t = typename traits::filter_traits<last_stage_t<N>>::ret_type;
+
+  template <std::size_t Lo, std::size_t Hi>
+  using slice_t =
+      typename slice<stages_type, Lo, std::make_index_sequence<Hi - Lo>>::type;
+
+  static constexpr std::size_t chunk_count =
+      (size + chunk_size - 1) / chunk_size;
+
+  template <std::size_t J>
+  using chunk_t =
+      slice_t<J * chunk_size,
+              ((J + 1) * chunk_size < size) ? (J + 1) * chunk_size : size>;
+
+  // apply stages [I, size) on the value produced by th
+  template <std::size_t I, typename Th>
+  static constexpr auto run_from(Th const &th) {
+    if constexpr (I == size) {
+      return th();
+    } else if constexpr (is_empty_v<I>) {
+      return run_from<I + 1>(th);
+    } else {
+      return run_from<I + 1>(defer_process<stage_t<I>>(th));
+    }
+  }
+
+  // apply stages [0, I) in reverse order on the value produced by th
+  template <std::size_t I, typename Th>
+  static constexpr auto run_reverse_from(Th const &th) {
+    if constexpr (I == 0) {
+      return th();
+    } else if constexpr (is_empty_v<I - 1>) {
+      return run_reverse_from<I - 1>(th);
+    } else {
+      return run_reverse_from<I - 1>(defer_reverse<stage_t<I - 1>>(th));
+    }
+  }
+
+  template <typename Th, std::size_t... Js>
+  static constexpr auto run_chunks(Th const &th, std::index_sequence<Js...>) {
+    return (chunk_t<0>::template run_from<0>(th) | ... | chunk_t<Js + 1>{});
+  }
+
+  template <typename Th, std::size_t... Js>
+  static constexpr auto run_reverse_chunks(Th const &th,
+                                           std::index_sequence<Js...>) {
+    constexpr std::size_t last = chunk_count - 1;
+    return (chunk_t<last>::template run_reverse_from<chunk_t<last>::size>(th) |
+            ... | reversed<chunk_t<last - Js - 1>>{});
+  }
+
+  template <typename Th> static constexpr auto run(Th const &th) {
+    if constexpr (chunk_count <= 1) {
+      return run_from<0>(th);
+    } else {
+      return run_chunks(th, std::make_index_sequence<chunk_count - 1>{});
+    }
+  }
+
+  template <typename Th> static constexpr auto run_reverse(Th const &th) {
+    if constexpr (chunk_count <= 1) {
+      return run_reverse_from<size>(th);
+    } else {
+      return run_reverse_chunks(th,
+                                std::make_index_sequence<chunk_count - 1>{});
+    }
+  }
+
+  // batch is split in halves, one intermediate block per level
+  template <typename In, typename Out>
+  static constexpr void run_batch(helpers::span<In const> in,
+                                  helpers::span<Out> out) {
+    if constexpr (stage_count <= 1) {
+      filter_process_batch<stage_t<first_stage<0>>, In, Out>(in, out);
+    } else {
+      using first_type = slice_t<0, size / 2>;
+      using next_type = slice_t<size / 2, size>;
+
+      chain_batch<stage_arg_t<size / 2>>(
+          in, out, [](auto i, auto o) { first_type::run_batch(i, o); },
+          [](auto i, auto o) { next_type::run_batch(i, o); },
+          [](In const &v) { return run([&]() -> In const & { return v; }); });
+    }
+  }
+
+  template <typename In, typename Out>
+  static constexpr void run_reverse_batch(helpers::span<In const> in,
+                                          helpers::span<Out> out) {
+    if constexpr (stage_count <= 1) {
+      filter_reverse_batch<stage_t<first_stage<0>>, In, Out>(in, out);
+    } else {
+      using first_type = slice_t<0, size / 2>;
+      using next_type = slice_t<size / 2, size>;
+
+      chain_batch<stage_arg_t<size / 2>>(
+          in, out, [](auto i, auto o) { next_type::run_reverse_batch(i, o); },
+          [](auto i, auto o) { first_type::run_reverse_batch(i, o); },
+          [](In const &v) {
+            return run_reverse([&]() -> In const & { return v; });
+          });
+    }
   }
 };
 
-template <typename F>
-struct end_element_impl<F, filter_proc>
-    : end_element_impl_varargs<F,
-                               typename traits::filter_traits<F>::args_type> {};
+template <typename... Fs>
+using stage_chain_t = make_stage_chain_t<helpers::typelist<void, Fs...>,
+                                         helpers::typelist<Fs..., void>>;
 
-template <typename F>
-struct end_element_impl<F, filter_rev_proc> : end_element_impl<F, filter_proc> {
-  using r_ret_type = typename traits::filter_traits<F>::ret_type;
+// first stage of a pipe and chain of the stages following it
+template <typename List, bool = is_fan_out_v<helpers::front_t<List>>>
+struct pipe_entry;
+
+template <typename F, typename... R>
+struct pipe_entry<helpers::typelist<F, R...>, false> {
+  using stage_type = F;
+  using next_type = make_stage_chain_t<helpers::typelist<F, R...>,
+                                       helpers::typelist<R..., void>>;
+};
+
+template <typename B, typename C, typename... R>
+struct pipe_entry<helpers::typelist<B, C, R...>, true> {
+  using stage_type = fan_out_stage<B, C>;
+  using next_type = make_stage_chain_t<helpers::typelist<C, R...>,
+                                       helpers::typelist<R..., void>>;
+};
 
-  static constexpr auto reverse(r_ret_type arg) {
-    return F::reverse(std::move(arg));
+template <typename B> struct fan_out_arg;
+
+template <template <typename...> typename B, typename... Ps>
+struct fan_out_arg<B<Ps...>> {
+  using type = helpers::front_t<
+      helpers::merge_all_t<typename traits::filter_traits<Ps>::args_type...>>;
+};
+
+// I/O compatibility of filter F (preceded by Prev) with the next filter
+template <typename Prev, typename F, typename Next>
+constexpr bool is_io_compatible() {
+  if constexpr (std::is_void_v<F> || std::is_void_v<Next> || is_fan_out_v<F>) {
+    // fan-out I/O is checked by the fan-out stage
+    return true;
+  } else {
+    using stage_type = typename stage_selector<Prev, F>::type;
+
+    if constexpr (is_fan_out_v<Next>) {
+      return std::is_convertible_v<
+          typename traits::filter_traits<stage_type>::ret_type,
+          typename fan_out_arg<Next>::type>;
+    } else {
+      return concept ::io_compatible<stage_type, Next>();
+    }
   }
+}
+
+template <typename Prevs, typename Fs, typename Nexts> struct io_compatible;
+
+template <typename... Prevs, typename... Fs, typename... Nexts>
+struct io_compatible<helpers::typelist<Prevs...>, helpers::typelist<Fs...>,
+                     helpers::typelist<Nexts...>> {
+  static constexpr bool mask[sizeof...(Fs) + 1] = {
+      is_io_compatible<Prevs, Fs, Nexts>()...};
+  static constexpr bool value =
+      helpers::count_set(mask, sizeof...(Fs)) == sizeof...(Fs);
 };
-} // namespace detail
 
-template <typename F, typename R>
-struct regular_element
-    : detail::regular_element_impl<
-          F, R, typename traits::filter_traits<F>::filter_type> {};
+template <typename Chain, typename Args> struct pipe_batch_impl {};
 
-template <typename F>
-struct end_element
-    : detail::end_element_impl<F,
-                               typename traits::filter_traits<F>::filter_type> {
+template <typename Chain, template <typename...> typename List, typename Arg>
+struct pipe_batch_impl<Chain, List<Arg>> {
+  using ret_type = typename Chain::template ret_t<>;
+
+  static constexpr void process_batch(helpers::span<Arg const> in,
+                                      helpers::span<ret_type> out) {
+    Chain::run_batch(in, out);
+  }
 };
 
-template <typename F, typename R>
-struct pipe_element_selector : regular_element<F, R> {};
+template <typename Chain, typename Entry,
+          typename T = typename traits::filter_traits<
+              typename Entry::stage_type>::filter_type>
+struct pipe_process_impl;
 
-template <typename F>
-struct pipe_element_selector<F, helpers::nonsuch> : end_element<F> {};
+// generator prefix details: the longest prefix of a pipe starting with a
+// generator that can be evaluated at compile time is materialized once as a
+// constant, runtime calls only apply the stages following it. The chain is
+// walked once from the last constant value, by chunks of
+// PIPET_CHAIN_CHUNK_SIZE slots and then slot by slot in the first chunk that
+// is not constant (linear work, instantiation depth bounded by the number
+// of chunks plus the chunk size)
 
-template <typename F, typename R = helpers::nonsuch>
-struct pipe_element : pipe_element_selector<F, R> {};
+template <typename Prefix> struct constant_prefix {
+  static constexpr auto value = Prefix::eval();
+};
 
-template <typename... Args> struct pipe;
+// generator followed by the first I stage slots, computed from the constant
+// value of the previous chunk boundary (I multiple of the chunk size) or of
+// the previous slot (only instantiated once that value is known constant)
+template <typename Entry, std::size_t I> struct gen_prefix {
+  static constexpr std::size_t chunk_size = PIPET_CHAIN_CHUNK_SIZE;
+  static constexpr std::size_t from =
+      (I == 0) ? 0 : ((I % chunk_size == 0) ? I - chunk_size : I - 1);
+  using chain_type = typename Entry::next_type::template slice_t<from, I>;
+
+  static constexpr auto eval() {
+    if constexpr (I == 0) {
+      return chain_type::run([]() { return Entry::stage_type::process(); });
+    } else {
+      return chain_type::run(
+          []() { return constant_prefix<gen_prefix<Entry, from>>::value; });
+    }
+  }
+};
+
+template <typename Prefix, typename = void>
+struct is_constant_prefix : std::false_type {};
+
+template <typename Prefix>
+struct is_constant_prefix<
+    Prefix, std::void_t<std::integral_constant<
+                bool, (static_cast<void>(Prefix::eval()), true)>>>
+    : std::is_copy_constructible<decltype(Prefix::eval())> {};
+
+// prefix of I slots known constant, N slots at most, one slot at a time
+template <typename Entry, std::size_t I, std::size_t N>
+constexpr std::size_t constant_prefix_slots() {
+  if constexpr (I == N) {
+    return I;
+  } else if constexpr (is_constant_prefix<gen_prefix<Entry, I + 1>>::value) {
+    return constant_prefix_slots<Entry, I + 1, N>();
+  } else {
+    return I;
+  }
+}
+
+// prefix of I slots known constant (I multiple of the chunk size), a chunk
+// at a time
+template <typename Entry, std::size_t I, std::size_t N>
+constexpr std::size_t constant_prefix_chunks() {
+  constexpr std::size_t next = I + PIPET_CHAIN_CHUNK_SIZE;
+  if constexpr (next > N) {
+    return constant_prefix_slots<Entry, I, N>();
+  } else if constexpr (is_constant_prefix<gen_prefix<Entry, next>>::value) {
+    return constant_prefix_chunks<Entry, next, N>();
+  } else {
+    return constant_prefix_slots<Entry, I, N>();
+  }
+}
+
+// number of filters (generator included) of the constant prefix, N stage
+// slots at most
+template <typename Entry, std::size_t N>
+constexpr std::size_t constant_prefix_size() {
+  if constexpr (is_constant_prefix<gen_prefix<Entry, 0>>::value) {
+    return constant_prefix_chunks<Entry, 0, N>() + 1;
+  } else {
+    return 0;
+  }
+}
+
+template <typename Chain, typename Entry>
+struct pipe_process_impl<Chain, Entry, filter_gen> {
+  using stage_type = typename Entry::stage_type;
+  using next_type = typename Entry::next_type;
+
+  // the last slot of the chain is the end of the pipe
+  static constexpr std::size_t folded_filters =
+      constant_prefix_size<Entry, next_type::size - 1>();
+
+  static constexpr auto process() {
+    if constexpr (folded_filters == 0) {
+      return next_type::run([]() { return stage_type::process(); });
+    } else {
+      using prefix_type = gen_prefix<Entry, folded_filters - 1>;
+      using suffix_type =
+          typename next_type::template slice_t<folded_filters - 1,
+                                               next_type::size>;
+
+      return suffix_type::run(
+          []() { return constant_prefix<prefix_type>::value; });
+    }
+  }
+};
+
+template <typename Chain, typename Entry, typename Params>
+struct pipe_process_impl_varargs;
+
+template <typename Chain, typename Entry,
+          template <typename...> typename List, typename... Params>
+struct pipe_process_impl_varargs<Chain, Entry, List<Params...>> {
+  using stage_type = typename Entry::stage_type;
+
+  static constexpr auto process(Params... params) {
+    return Entry::next_type::run([&]() {
+      return stage_type::process(std::forward<Params>(params)...);
+    });
+  }
+
+  template <typename Th> static constexpr auto process_deferred(Th const &th) {
+    return Chain::run(th);
+  }
+};
+
+template <typename Chain, typename Entry>
+struct pipe_process_impl<Chain, Entry, filter_proc>
+    : pipe_process_impl_varargs<
+          Chain, Entry,
+          typename traits::filter_traits<
+              typename Entry::stage_type>::params_type>,
+      pipe_batch_impl<Chain, typename traits::filter_traits<
+                                 typename Entry::stage_type>::args_type> {};
+
+template <typename Chain, typename Entry>
+struct pipe_process_impl<Chain, Entry, filter_rev_proc>
+    : pipe_process_impl<Chain, Entry, filter_proc> {};
+
+template <typename Chain, bool Reversible> struct pipe_reverse_impl {};
+
+template <typename Chain> struct pipe_reverse_impl<Chain, true> {
+  using reverse_param_type =
+      reverse_param_t<typename Chain::template last_stage_t<>>;
+
+  static constexpr auto reverse(reverse_param_type arg) {
+    return reverse_deferred([&]() -> decltype(auto) {
+      return std::forward<reverse_param_type>(arg);
+    });
+  }
+
+  template <typename Th> static constexpr auto reverse_deferred(Th const &th) {
+    return Chain::run_reverse(th);
+  }
+
+  using r_ret_type = typename Chain::template ret_t<>;
+  using f_arg_type = typename Chain::template stage_arg_t<0>;
+
+  static constexpr void reverse_batch(helpers::span<r_ret_type const> in,
+                                      helpers::span<f_arg_type> out) {
+    Chain::run_reverse_batch(in, out);
+  }
+};
+
+template <typename... Fs> struct is_reversible {
+  static constexpr bool reversible[sizeof...(Fs) + 1] = {
+      std::is_same_v<typename traits::filter_traits<Fs>::filter_type,
+                     filter_rev_proc>...};
+  static constexpr bool fan_outs[sizeof...(Fs) + 1] = {is_fan_out_v<Fs>...};
+  static constexpr bool value =
+      helpers::count_set(reversible, sizeof...(Fs)) == sizeof...(Fs) &&
+      helpers::count_set(fan_outs, sizeof...(Fs)) == 0;
+};
+
+template <typename... Fs>
+constexpr bool is_reversible_v = is_reversible<Fs...>::value;
 
 template <typename F, typename... R>
-struct pipe<F, R...> : pipe_element<F, pipe<R...>> {};
+struct pipe_impl
+    : pipe_process_impl<stage_chain_t<F, R...>,
+                        pipe_entry<helpers::typelist<F, R...>>>,
+      pipe_reverse_impl<stage_chain_t<F, R...>, is_reversible_v<F, R...>> {
+  using filters_type = helpers::typelist<F, R...>;
+
+  static_assert(!is_fan_out_v<helpers::at_t<sizeof...(R),
+                                            helpers::typelist<F, R...>>>,
+                "[-][pipet] branches must be followed by a multi-args filter");
+  static_assert(io_compatible<helpers::typelist<void, F, R...>,
+                              helpers::typelist<F, R..., void>,
+                              helpers::typelist<R..., void, void>>::value,
+                "[-][pipet] requirement not met");
+};
 
-template <typename F> struct pipe<F> : pipe_element<F> {};
+template <typename List> struct pipe_impl_of;
+
+template <typename... Fs> struct pipe_impl_of<helpers::typelist<Fs...>> {
+  using type = pipe_impl<Fs...>;
+};
+
+// pipe running the filters left by the optimization pass
+template <typename F, typename... R>
+using optimized_pipe_impl_t =
+    typename pipe_impl_of<optimize_t<F, R...>>::type;
+} // namespace detail
+
+template <typename F, typename... R>
+struct pipe<F, R...> : detail::optimized_pipe_impl_t<F, R...> {};
+
+// Former recursive pipe elements, kept as deprecated aliases of the pipe
+// they used to build (element F followed by the element or pipe R)
+namespace detail {
+template <typename F, typename R> struct element_pipe {
+  using type = pipe<F, R>;
+};
+
+template <typename F, typename... Rs> struct element_pipe<F, pipe<Rs...>> {
+  using type = pipe<F, Rs...>;
+};
+
+template <typename F> struct element_pipe<F, helpers::nonsuch> {
+  using type = pipe<F>;
+};
+} // namespace detail
+
+template <typename F, typename R>
+using regular_element [[deprecated("[-][pipet] use pipe<F, ...>")]] =
+    typename detail::element_pipe<F, R>::type;
+
+template <typename F>
+using end_element [[deprecated("[-][pipet] use pipe<F>")]] = pipe<F>;
+
+template <typename F, typename R = helpers::nonsuch>
+using pipe_element [[deprecated("[-][pipet] use pipe<F, ...>")]] =
+    typename detail::element_pipe<F, R>::type;
 } // namespace pipet
\ No newline at end of file
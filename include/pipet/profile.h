@@ -0,0 +1,504 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "pipet.h"
+#include "helpers/cpu.h"
+#include "helpers/reflect.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+// clock used to time filter calls (any chrono clock, e.g. a cycle counter
+// wrapper)
+#ifndef PIPET_PROFILE_CLOCK
+#define PIPET_PROFILE_CLOCK std::chrono::steady_clock
+#endif
+
+namespace pipet {
+// instrumentation policy: pipe<profile, Fs...> times every filter call
+struct profile {};
+
+// latency statistics of one filter path (process, reverse...)
+struct profile_stats {
+  static constexpr std::size_t buckets = 64;
+
+  std::uint64_t count{0};
+  std::uint64_t total_ns{0};
+  std::uint64_t min_ns{UINT64_MAX};
+  std::uint64_t max_ns{0};
+  // bucket i counts the calls lasting in [2^(i-1), 2^i) ns, bucket 0 the
+  // calls lasting less than 1 ns
+  std::array<std::uint64_t, buckets> histogram{};
+
+  void merge(profile_stats const &other) {
+    count += other.count;
+    total_ns += other.total_ns;
+    min_ns = (std::min)(min_ns, other.min_ns);
+    max_ns = (std::max)(max_ns, other.max_ns);
+    for (std::size_t i = 0; i < buckets; ++i) {
+      histogram[i] += other.histogram[i];
+    }
+  }
+
+  std::uint64_t mean_ns() const { return count ? total_ns / count : 0; }
+
+  // upper bound of the bucket holding the q-quantile (0 < q <= 1)
+  std::uint64_t quantile_ns(double q) const {
+    auto const rank = static_cast<std::uint64_t>(q * count);
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets; ++i) {
+      seen += histogram[i];
+      if (seen > 0 && seen >= rank) {
+        return (std::uint64_t{1} << i) - 1;
+      }
+    }
+    return max_ns;
+  }
+};
+
+struct profile_entry {
+  std::string_view filter;
+  std::string_view path;
+  profile_stats stats;
+};
+
+namespace detail {
+// profiling details: each thread records its calls in its own counters (no
+// contention), counters of all threads are merged on demand
+
+constexpr std::size_t latency_bucket(std::uint64_t ns) {
+  std::size_t b = 0;
+  while (ns && b < profile_stats::buckets - 1) {
+    ns >>= 1;
+    ++b;
+  }
+  return b;
+}
+
+// counters of one filter path for one thread (single writer)
+class profile_counters {
+  std::atomic<std::uint64_t> m_count{0};
+  std::atomic<std::uint64_t> m_total{0};
+  std::atomic<std::uint64_t> m_min{UINT64_MAX};
+  std::atomic<std::uint64_t> m_max{0};
+  std::array<std::atomic<std::uint64_t>, profile_stats::buckets> m_histogram{};
+
+  // no read-modify-write needed with a single writer
+  static void add(std::atomic<std::uint64_t> &a, std::uint64_t v) {
+    a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+  }
+
+public:
+  void record(std::uint64_t ns) {
+    add(m_count, 1);
+    add(m_total, ns);
+    if (ns < m_min.load(std::memory_order_relaxed)) {
+      m_min.store(ns, std::memory_order_relaxed);
+    }
+    if (ns > m_max.load(std::memory_order_relaxed)) {
+      m_max.store(ns, std::memory_order_relaxed);
+    }
+    add(m_histogram[latency_bucket(ns)], 1);
+  }
+
+  profile_stats load() const {
+    profile_stats s;
+    s.count = m_count.load(std::memory_order_relaxed);
+    s.total_ns = m_total.load(std::memory_order_relaxed);
+    s.min_ns = m_min.load(std::memory_order_relaxed);
+    s.max_ns = m_max.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < profile_stats::buckets; ++i) {
+      s.histogram[i] = m_histogram[i].load(std::memory_order_relaxed);
+    }
+    return s;
+  }
+
+  // samples recorded concurrently by the owner thread may be lost
+  void clear() {
+    m_count.store(0, std::memory_order_relaxed);
+    m_total.store(0, std::memory_order_relaxed);
+    m_min.store(UINT64_MAX, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+    for (auto &h : m_histogram) {
+      h.store(0, std::memory_order_relaxed);
+    }
+  }
+};
+
+class profile_site;
+
+class profile_registry {
+  std::mutex m_mutex;
+  std::vector<profile_site *> m_sites;
+
+public:
+  // never destroyed: pool threads may exit after static destruction
+  static profile_registry &get() {
+    static auto *registry = new profile_registry;
+    return *registry;
+  }
+
+  void add(profile_site *site) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_sites.push_back(site);
+  }
+
+  std::vector<profile_entry> collect();
+
+  void reset();
+};
+
+// one filter path, with the counters of the threads that went through it
+class profile_site {
+  std::string_view m_filter;
+  std::string_view m_path;
+  std::mutex m_mutex;
+  std::vector<profile_counters *> m_live;
+  profile_stats m_retired;
+
+public:
+  profile_site(std::string_view filter, std::string_view path)
+      : m_filter{filter}, m_path{path} {
+    profile_registry::get().add(this);
+  }
+
+  void attach(profile_counters *counters) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_live.push_back(counters);
+  }
+
+  // counters of an exiting thread are kept in the retired stats
+  void detach(profile_counters *counters) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_retired.merge(counters->load());
+    m_live.erase(std::find(m_live.begin(), m_live.end(), counters));
+  }
+
+  profile_entry collect() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    profile_entry entry{m_filter, m_path, m_retired};
+    for (auto const *c : m_live) {
+      entry.stats.merge(c->load());
+    }
+    return entry;
+  }
+
+  void reset() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_retired = profile_stats{};
+    for (auto *c : m_live) {
+      c->clear();
+    }
+  }
+};
+
+inline std::vector<profile_entry> profile_registry::collect() {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  std::vector<profile_entry> entries;
+  for (auto *site : m_sites) {
+    entries.push_back(site->collect());
+  }
+  return entries;
+}
+
+inline void profile_registry::reset() {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  for (auto *site : m_sites) {
+    site->reset();
+  }
+}
+
+class profile_thread_counters {
+  profile_site &m_site;
+
+public:
+  profile_counters counters;
+
+  explicit profile_thread_counters(profile_site &site) : m_site{site} {
+    m_site.attach(&counters);
+  }
+
+  ~profile_thread_counters() { m_site.detach(&counters); }
+
+  profile_thread_counters(profile_thread_counters const &) = delete;
+  profile_thread_counters &operator=(profile_thread_counters const &) = delete;
+};
+
+struct process_path {
+  static constexpr std::string_view name = "process";
+};
+
+struct reverse_path {
+  static constexpr std::string_view name = "reverse";
+};
+
+struct process_batch_path {
+  static constexpr std::string_view name = "process_batch";
+};
+
+struct reverse_batch_path {
+  static constexpr std::string_view name = "reverse_batch";
+};
+
+template <typename F, typename Path> struct profile_point {
+  // never destroyed, see profile_registry
+  static profile_site &site() {
+    static auto *s = new profile_site{helpers::type_name<F>(), Path::name};
+    return *s;
+  }
+
+  static profile_counters &local() {
+    thread_local profile_thread_counters c{site()};
+    return c.counters;
+  }
+};
+
+// times the enclosing scope (the filter call and its result construction)
+template <typename F, typename Path> class profile_scope {
+  using clock = PIPET_PROFILE_CLOCK;
+
+  typename clock::time_point m_start{clock::now()};
+
+public:
+  profile_scope() = default;
+  profile_scope(profile_scope const &) = delete;
+  profile_scope &operator=(profile_scope const &) = delete;
+
+  ~profile_scope() {
+    auto const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        clock::now() - m_start);
+    profile_point<F, Path>::local().record(
+        static_cast<std::uint64_t>(elapsed.count()));
+  }
+};
+
+template <typename F>
+using profiled_ret_t = decltype(helpers::function_ret(&F::process));
+
+template <typename F, typename Params> struct profiled_process;
+
+// constant evaluations are not timed (kept constexpr for the compilers
+// telling them apart)
+template <typename F, template <typename...> typename List,
+          typename... Params>
+struct profiled_process<F, List<Params...>> {
+  static constexpr profiled_ret_t<F> process(Params... params) {
+#if PIPET_HAS_CONSTANT_EVALUATED
+    if (helpers::is_constant_evaluated()) {
+      return F::process(std::forward<Params>(params)...);
+    }
+#endif
+    return timed_process(std::forward<Params>(params)...);
+  }
+
+private:
+  static profiled_ret_t<F> timed_process(Params... params) {
+    profile_scope<F, process_path> scope;
+    return F::process(std::forward<Params>(params)...);
+  }
+};
+
+template <typename F, bool = std::is_same_v<
+                          typename traits::filter_traits<F>::filter_type,
+                          filter_rev_proc>>
+struct profiled_reverse {};
+
+template <typename F> struct profiled_reverse<F, true> {
+  using param_type = reverse_param_t<F>;
+
+  static constexpr decltype(auto) reverse(param_type arg) {
+#if PIPET_HAS_CONSTANT_EVALUATED
+    if (helpers::is_constant_evaluated()) {
+      return F::reverse(std::forward<param_type>(arg));
+    }
+#endif
+    return timed_reverse(std::forward<param_type>(arg));
+  }
+
+private:
+  static decltype(auto) timed_reverse(param_type arg) {
+    profile_scope<F, reverse_path> scope;
+    return F::reverse(std::forward<param_type>(arg));
+  }
+};
+
+// filter own batch routines are timed per block, other filters per value
+template <typename F, typename In, typename Out,
+          bool = helpers::is_detected_v<process_batch_t, F, In, Out>>
+struct profiled_process_batch {};
+
+template <typename F, typename In, typename Out>
+struct profiled_process_batch<F, In, Out, true> {
+  static void process_batch(helpers::span<In const> in,
+                            helpers::span<Out> out) {
+    profile_scope<F, process_batch_path> scope;
+    F::process_batch(in, out);
+  }
+};
+
+template <typename F, typename In, typename Out,
+          bool = helpers::is_detected_v<reverse_batch_t, F, Out, In>>
+struct profiled_reverse_batch {};
+
+template <typename F, typename In, typename Out>
+struct profiled_reverse_batch<F, In, Out, true> {
+  static void reverse_batch(helpers::span<Out const> in,
+                            helpers::span<In> out) {
+    profile_scope<F, reverse_batch_path> scope;
+    F::reverse_batch(in, out);
+  }
+};
+
+template <typename F> struct profiled_io {
+  using in_type = std::decay_t<
+      helpers::robust_front_t<typename traits::filter_traits<F>::args_type>>;
+  using out_type = typename traits::filter_traits<F>::ret_type;
+};
+
+template <typename F> struct profiled_select;
+
+// optimization traits of F (optimize.h) forwarded to profiled<F>, so that a
+// profiled pipe runs the stages of the plain pipe
+template <typename F, typename = void> struct profiled_inverse {};
+
+template <typename F>
+struct profiled_inverse<F, std::void_t<inverse_type_t<F>>> {
+  using inverse_type = typename profiled_select<inverse_type_t<F>>::type;
+};
+
+template <typename F, typename = void> struct profiled_commute_group {};
+
+template <typename F>
+struct profiled_commute_group<F, std::void_t<commute_group_t<F>>> {
+  using commute_group = commute_group_t<F>;
+};
+
+template <typename F, typename = void> struct profiled_cost {};
+
+template <typename F> struct profiled_cost<F, std::void_t<cost_t<F>>> {
+  static constexpr std::size_t cost = F::cost;
+};
+} // namespace detail
+
+// filter adaptor timing each call of F, reported under the F type name
+template <typename F>
+struct profiled
+    : detail::profiled_process<
+          F, typename traits::filter_traits<F>::params_type>,
+      detail::profiled_reverse<F>,
+      detail::profiled_process_batch<F,
+                                     typename detail::profiled_io<F>::in_type,
+                                     typename detail::profiled_io<F>::out_type>,
+      detail::profiled_reverse_batch<
+          F, typename detail::profiled_io<F>::in_type,
+          typename detail::profiled_io<F>::out_type>,
+      detail::profiled_inverse<F>,
+      detail::profiled_commute_group<F>,
+      detail::profiled_cost<F> {};
+
+namespace detail {
+template <typename F> struct profiled_select { using type = profiled<F>; };
+
+template <> struct profiled_select<placeholders::self> {
+  using type = placeholders::self;
+};
+
+// the adaptor keeps wrapping F, so that F, inverse<F> still cancel out (F
+// reverse path timed)
+template <typename F> struct profiled_select<inverse<F>> {
+  using type = inverse<typename profiled_select<F>::type>;
+};
+
+// each branch is timed as a whole
+template <typename... Ps> struct profiled_select<branches<Ps...>> {
+  using type = branches<typename profiled_select<Ps>::type...>;
+};
+
+template <typename... Ps> struct profiled_select<par_branches<Ps...>> {
+  using type = par_branches<typename profiled_select<Ps>::type...>;
+};
+
+template <typename F>
+using profiled_select_t = typename profiled_select<F>::type;
+
+template <typename F, typename G, typename = void> struct profiled_compose {};
+
+template <typename F, typename G>
+struct profiled_compose<F, G, std::void_t<compose_type_t<F, G>>> {
+  using type = profiled_select_t<compose_type_t<F, G>>;
+};
+} // namespace detail
+
+namespace traits {
+// composition of profiled filters: the profiled composition of the filters
+template <typename F, typename G>
+struct compose<profiled<F>, profiled<G>> : detail::profiled_compose<F, G> {};
+} // namespace traits
+
+// with PIPET_DISABLE_PROFILE, a profiled pipe is the plain pipe
+#ifdef PIPET_DISABLE_PROFILE
+template <typename F, typename... R>
+struct pipe<profile, F, R...> : pipe<F, R...> {};
+#else
+template <typename F, typename... R>
+struct pipe<profile, F, R...>
+    : pipe<detail::profiled_select_t<F>, detail::profiled_select_t<R>...> {};
+#endif
+
+// merged statistics of all profiled filters
+struct profiler {
+  // entries sorted by decreasing total time
+  static std::vector<profile_entry> report() {
+    auto entries = detail::profile_registry::get().collect();
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](auto const &a, auto const &b) {
+                       return a.stats.total_ns > b.stats.total_ns;
+                     });
+    return entries;
+  }
+
+  static void reset() { detail::profile_registry::get().reset(); }
+
+  static void dump(std::ostream &os) {
+    os << std::left << std::setw(40) << "filter" << std::setw(15) << "path"
+       << std::right << std::setw(12) << "calls" << std::setw(14)
+       << "total (ns)" << std::setw(12) << "mean" << std::setw(12) << "min"
+       << std::setw(12) << "p50" << std::setw(12) << "p99" << std::setw(12)
+       << "max" << '\n';
+
+    for (auto const &e : report()) {
+      if (!e.stats.count) {
+        continue;
+      }
+      os << std::left << std::setw(40) << e.filter << std::setw(15) << e.path
+         << std::right << std::setw(12) << e.stats.count << std::setw(14)
+         << e.stats.total_ns << std::setw(12) << e.stats.mean_ns()
+         << std::setw(12) << e.stats.min_ns << std::setw(12)
+         << e.stats.quantile_ns(0.5) << std::setw(12)
+         << e.stats.quantile_ns(0.99) << std::setw(12) << e.stats.max_ns
+         << '\n';
+    }
+  }
+};
+} // namespace pipet
\ No newline at end of file
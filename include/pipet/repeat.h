@@ -0,0 +1,226 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "filter.h"
+#include "helpers/reflect.h"
+#include "helpers/typelist.h"
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace pipet {
+template <typename... Args> struct pipe;
+
+// compile-time round index given to the filters of a fully unrolled repeat
+template <std::size_t I>
+using round_index = std::integral_constant<std::size_t, I>;
+
+// filters of a round taking the round index (as a second argument), only
+// usable as the repeated pipe of a repeat (this is not a pipe)
+template <typename F, typename... Fs> struct round_pipe {};
+
+namespace detail {
+// repeat details: a round applies the filters of the repeated pipe in turn,
+// a filter taking a second argument is given the round index (round_index<I>
+// when fully unrolled, std::size_t otherwise)
+
+template <typename F, typename T, typename R>
+using round_process_t =
+    decltype(F::process(std::declval<T>(), std::declval<R>()));
+
+template <typename F, typename T, typename R>
+using round_reverse_t =
+    decltype(F::reverse(std::declval<T>(), std::declval<R>()));
+
+template <typename F, typename T>
+constexpr bool is_round_filter_v =
+    helpers::is_detected_v<round_process_t, F, T, round_index<0>>;
+
+template <typename F, typename T, typename R>
+constexpr auto round_process(T &&arg, R round) {
+  if constexpr (is_round_filter_v<F, T>) {
+    static_assert(helpers::is_detected_v<round_process_t, F, T, R>,
+                  "[-][pipet] filter needs a compile-time round index (full "
+                  "unroll)");
+    return F::process(std::forward<T>(arg), round);
+  } else {
+    return F::process(std::forward<T>(arg));
+  }
+}
+
+template <typename F, typename T, typename R>
+constexpr auto round_reverse(T &&arg, R round) {
+  if constexpr (helpers::is_detected_v<round_reverse_t, F, T,
+                                       round_index<0>>) {
+    static_assert(helpers::is_detected_v<round_reverse_t, F, T, R>,
+                  "[-][pipet] filter needs a compile-time round index (full "
+                  "unroll)");
+    return F::reverse(std::forward<T>(arg), round);
+  } else {
+    return F::reverse(std::forward<T>(arg));
+  }
+}
+
+template <typename F, typename T>
+using plain_reverse_t = decltype(F::reverse(std::declval<T>()));
+
+template <typename F, typename... Fs> struct round_filters {
+  // all filters can be reversed (with or without round index)
+  template <typename T> static constexpr bool is_reversible() {
+    using out_type =
+        decltype(round_process<F>(std::declval<T>(), round_index<0>{}));
+    constexpr bool f_reversible =
+        helpers::is_detected_v<round_reverse_t, F, out_type,
+                               round_index<0>> ||
+        helpers::is_detected_v<plain_reverse_t, F, out_type>;
+
+    if constexpr (sizeof...(Fs) == 0) {
+      return f_reversible;
+    } else {
+      return f_reversible &&
+             round_filters<Fs...>::template is_reversible<out_type>();
+    }
+  }
+
+  template <typename T, typename R>
+  static constexpr auto process(T &&arg, R round) {
+    if constexpr (sizeof...(Fs) == 0) {
+      return round_process<F>(std::forward<T>(arg), round);
+    } else {
+      return round_filters<Fs...>::process(
+          round_process<F>(std::forward<T>(arg), round), round);
+    }
+  }
+
+  template <typename T, typename R>
+  static constexpr auto reverse(T &&arg, R round) {
+    if constexpr (sizeof...(Fs) == 0) {
+      return round_reverse<F>(std::forward<T>(arg), round);
+    } else {
+      return round_reverse<F>(
+          round_filters<Fs...>::reverse(std::forward<T>(arg), round), round);
+    }
+  }
+};
+
+template <typename P> struct repeat_traits;
+
+template <typename F, typename... Fs> struct repeat_traits<pipe<F, Fs...>> {
+  using round_type = round_filters<F, Fs...>;
+  using value_type = std::decay_t<
+      helpers::front_t<typename traits::filter_traits<F>::args_type>>;
+};
+
+// value type read from the first filter (non template process)
+template <typename F, typename... Fs>
+struct repeat_traits<round_pipe<F, Fs...>>
+    : repeat_traits<pipe<F, Fs...>> {};
+
+template <typename P, std::size_t N, std::size_t Unroll> struct repeat_impl {
+  using round_type = typename repeat_traits<P>::round_type;
+  using value_type = typename repeat_traits<P>::value_type;
+
+  static_assert(N == 0 || (Unroll > 0 && Unroll <= N),
+                "[-][pipet] bad unroll factor");
+  static_assert(std::is_same_v<std::decay_t<decltype(round_type::process(
+                                   std::declval<value_type>(),
+                                   round_index<0>{}))>,
+                               value_type>,
+                "[-][pipet] repeated pipe must output its input type");
+
+  // rounds [Base, Base + sizeof...(Is)) (Base runtime or compile-time)
+  template <typename B, std::size_t... Is>
+  static constexpr void process_block(value_type &v, B base,
+                                      std::index_sequence<Is...>) {
+    if constexpr (std::is_same_v<B, std::size_t>) {
+      ((v = round_type::process(std::move(v), base + Is)), ...);
+    } else {
+      ((v = round_type::process(std::move(v), round_index<B::value + Is>{})),
+       ...);
+    }
+  }
+
+  template <typename B, std::size_t... Is>
+  static constexpr void reverse_block(value_type &v, B base,
+                                      std::index_sequence<Is...>) {
+    constexpr std::size_t last = sizeof...(Is) - 1;
+    if constexpr (std::is_same_v<B, std::size_t>) {
+      ((v = round_type::reverse(std::move(v), base + last - Is)), ...);
+    } else {
+      ((v = round_type::reverse(std::move(v),
+                                round_index<B::value + last - Is>{})),
+       ...);
+    }
+  }
+
+  // N / Unroll blocks run in a loop, the remaining rounds unrolled
+  static constexpr std::size_t loop_rounds = N - N % Unroll;
+
+  static constexpr value_type process(value_type v) {
+    if constexpr (Unroll == N) {
+      process_block(v, round_index<0>{}, std::make_index_sequence<N>{});
+    } else {
+      for (std::size_t b = 0; b < loop_rounds; b += Unroll) {
+        process_block(v, b, std::make_index_sequence<Unroll>{});
+      }
+      process_block(v, round_index<loop_rounds>{},
+                    std::make_index_sequence<N % Unroll>{});
+    }
+    return v;
+  }
+
+  static constexpr value_type reverse(value_type v) {
+    if constexpr (Unroll == N) {
+      reverse_block(v, round_index<0>{}, std::make_index_sequence<N>{});
+    } else {
+      reverse_block(v, round_index<loop_rounds>{},
+                    std::make_index_sequence<N % Unroll>{});
+      for (std::size_t b = loop_rounds; b > 0; b -= Unroll) {
+        reverse_block(v, b - Unroll, std::make_index_sequence<Unroll>{});
+      }
+    }
+    return v;
+  }
+};
+
+template <typename P, std::size_t N, std::size_t Unroll,
+          bool = repeat_traits<P>::round_type::template is_reversible<
+              typename repeat_traits<P>::value_type>()>
+struct repeat_rev_impl {
+  using value_type = typename repeat_traits<P>::value_type;
+
+  static constexpr value_type process(value_type v) {
+    return repeat_impl<P, N, Unroll>::process(std::move(v));
+  }
+};
+
+template <typename P, std::size_t N, std::size_t Unroll>
+struct repeat_rev_impl<P, N, Unroll, true>
+    : repeat_rev_impl<P, N, Unroll, false> {
+  using typename repeat_rev_impl<P, N, Unroll, false>::value_type;
+
+  static constexpr value_type reverse(value_type v) {
+    return repeat_impl<P, N, Unroll>::reverse(std::move(v));
+  }
+};
+} // namespace detail
+
+// filter running the filters of P (pipe or round_pipe) for N rounds, Unroll
+// rounds per loop iteration (N: fully unrolled, 1: rolled loop)
+template <typename P, std::size_t N, std::size_t Unroll = N>
+struct repeat : detail::repeat_rev_impl<P, N, Unroll> {};
+} // namespace pipet
\ No newline at end of file
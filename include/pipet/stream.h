@@ -0,0 +1,272 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "pipet.h"
+#include "helpers/spsc_queue.h"
+
+#include <array>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace pipet {
+namespace detail {
+// stream stages building: a branch point is fused with the multi-args filter
+// consuming its results, other filters (including nested pipes used to group
+// several filters on one thread) are run on their own thread
+
+template <typename List> struct stream_stages;
+
+template <template <typename...> typename List>
+struct stream_stages<List<>> {
+  using type = helpers::typelist<>;
+};
+
+template <template <typename...> typename List, typename F, typename... Fs>
+struct stream_stages<List<F, Fs...>> {
+  using type =
+      helpers::push_front_t<F, typename stream_stages<List<Fs...>>::type>;
+};
+
+template <template <typename...> typename List, typename... Ps, typename R,
+          typename... Fs>
+struct stream_stages<List<branches<Ps...>, R, Fs...>> {
+  using type = helpers::push_front_t<pipe<branches<Ps...>, R>,
+                                     typename stream_stages<List<Fs...>>::type>;
+};
+
+template <template <typename...> typename List, typename... Ps, typename R,
+          typename... Fs>
+struct stream_stages<List<par_branches<Ps...>, R, Fs...>> {
+  using type = helpers::push_front_t<pipe<par_branches<Ps...>, R>,
+                                     typename stream_stages<List<Fs...>>::type>;
+};
+
+template <typename Pipe>
+using stream_stages_t = typename stream_stages<Pipe>::type;
+
+template <std::size_t Capacity, typename Stages> class stream_runner_impl;
+
+template <std::size_t Capacity, typename S, typename... Ss>
+class stream_runner_impl<Capacity, helpers::typelist<S, Ss...>> {
+  static_assert(helpers::size_v<typename traits::filter_traits<S>::args_type> ==
+                    1,
+                "[-][pipet] stream first filter must have one input");
+
+  using stages_type = std::tuple<S, Ss...>;
+  static constexpr std::size_t stage_count = 1 + sizeof...(Ss);
+
+  template <typename F>
+  using out_queue_t =
+      helpers::spsc_queue<typename traits::filter_traits<F>::ret_type,
+                          Capacity>;
+
+public:
+  using in_type = helpers::front_t<typename traits::filter_traits<S>::args_type>;
+  using out_type = typename traits::filter_traits<
+      std::tuple_element_t<stage_count - 1, stages_type>>::ret_type;
+
+private:
+  // queue I feeds stage I, last queue holds pipe results
+  std::tuple<std::unique_ptr<helpers::spsc_queue<in_type, Capacity>>,
+             std::unique_ptr<out_queue_t<S>>, std::unique_ptr<out_queue_t<Ss>>...>
+      m_queues{std::make_unique<helpers::spsc_queue<in_type, Capacity>>(),
+               std::make_unique<out_queue_t<S>>(),
+               std::make_unique<out_queue_t<Ss>>()...};
+
+  // queue I will not receive any new item
+  std::array<std::atomic<bool>, stage_count + 1> m_closed{};
+  std::atomic<bool> m_stop{false};
+
+  // producer and consumer of queue I wait on waiter I (idle stages sleep)
+  std::array<helpers::queue_waiter, stage_count + 1> m_waiters;
+
+  std::mutex m_error_mutex;
+  std::exception_ptr m_error;
+
+  std::vector<std::thread> m_threads;
+
+  template <std::size_t... Is> void start(std::index_sequence<Is...>) {
+    m_threads.reserve(stage_count);
+    (m_threads.emplace_back([this] { run_stage<Is>(); }), ...);
+  }
+
+  bool stopped() const { return m_stop.load(std::memory_order_relaxed); }
+
+  template <std::size_t I> void run_stage() {
+    using stage_type = std::tuple_element_t<I, stages_type>;
+    auto &in = *std::get<I>(m_queues);
+    auto &out = *std::get<I + 1>(m_queues);
+
+    try {
+      while (!stopped()) {
+        if (auto v = in.try_pop()) {
+          m_waiters[I].notify();
+          auto res = stage_type::process(std::move(*v));
+
+          // full output queue applies backpressure on this stage
+          while (!out.try_push(std::move(res))) {
+            m_waiters[I + 1].wait([&] { return !out.full() || stopped(); });
+            if (stopped()) {
+              return;
+            }
+          }
+          m_waiters[I + 1].notify();
+        } else if (m_closed[I].load(std::memory_order_acquire)) {
+          if (in.empty()) {
+            break;
+          }
+        } else {
+          m_waiters[I].wait([&] {
+            return !in.empty() || m_closed[I].load(std::memory_order_acquire) ||
+                   stopped();
+          });
+        }
+      }
+    } catch (...) {
+      fail(std::current_exception());
+    }
+
+    m_closed[I + 1].store(true, std::memory_order_release);
+    m_waiters[I + 1].notify();
+  }
+
+  void stop() {
+    m_stop = true;
+    for (auto &w : m_waiters) {
+      w.notify();
+    }
+  }
+
+  void fail(std::exception_ptr error) {
+    {
+      std::lock_guard<std::mutex> lock{m_error_mutex};
+      if (!m_error) {
+        m_error = std::move(error);
+      }
+    }
+    stop();
+  }
+
+  auto &in_queue() { return *std::get<0>(m_queues); }
+
+  auto &out_queue() { return *std::get<stage_count>(m_queues); }
+
+  bool notify_pushed(bool pushed) {
+    if (pushed) {
+      m_waiters[0].notify();
+    }
+    return pushed;
+  }
+
+  void check() {
+    if (stopped()) {
+      std::lock_guard<std::mutex> lock{m_error_mutex};
+      if (m_error) {
+        std::rethrow_exception(m_error);
+      }
+    }
+  }
+
+public:
+  stream_runner_impl() { start(std::make_index_sequence<stage_count>{}); }
+
+  stream_runner_impl(stream_runner_impl const &) = delete;
+  stream_runner_impl &operator=(stream_runner_impl const &) = delete;
+
+  // stop all stages, pending items are discarded
+  ~stream_runner_impl() {
+    stop();
+    for (auto &t : m_threads) {
+      t.join();
+    }
+  }
+
+  static constexpr std::size_t stages() { return stage_count; }
+
+  bool try_push(in_type const &v) {
+    return notify_pushed(in_queue().try_push(v));
+  }
+
+  bool try_push(in_type &&v) {
+    return notify_pushed(in_queue().try_push(std::move(v)));
+  }
+
+  // block while the first stage is saturated
+  template <typename T> void push(T &&v) {
+    while (!try_push(std::forward<T>(v))) {
+      check();
+      m_waiters[0].wait([this] { return !in_queue().full() || stopped(); });
+    }
+  }
+
+  // signal end of input, stages finish once their input is drained
+  void close() {
+    m_closed[0].store(true, std::memory_order_release);
+    m_waiters[0].notify();
+  }
+
+  std::optional<out_type> try_pop() {
+    check();
+    auto res = out_queue().try_pop();
+    if (res) {
+      m_waiters[stage_count].notify();
+    }
+    return res;
+  }
+
+  // block until a result is available or the closed stream is drained
+  std::optional<out_type> pop() {
+    auto &out = out_queue();
+
+    for (;;) {
+      check();
+
+      if (auto v = out.try_pop()) {
+        m_waiters[stage_count].notify();
+        return v;
+      }
+
+      if (m_closed[stage_count].load(std::memory_order_acquire) &&
+          out.empty()) {
+        check();
+        return std::nullopt;
+      }
+
+      m_waiters[stage_count].wait([&] {
+        return !out.empty() ||
+               m_closed[stage_count].load(std::memory_order_acquire) ||
+               stopped();
+      });
+    }
+  }
+};
+} // namespace detail
+
+// pipelined execution of a pipe: one thread per filter of the optimized pipe,
+// adjacent filters are connected through bounded spsc queues. Filters grouped
+// in a nested pipe share a thread, an idle stage sleeps after a short spin.
+template <typename Pipe, std::size_t Capacity = 1024>
+class stream_runner
+    : public detail::stream_runner_impl<
+          Capacity, detail::stream_stages_t<typename Pipe::filters_type>> {};
+} // namespace pipet
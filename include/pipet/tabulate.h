@@ -0,0 +1,201 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "filter.h"
+#include "helpers/span.h"
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+// default bound of the memory used by the tables of a tabulated filter
+#ifndef PIPET_TABULATE_MAX_BYTES
+#define PIPET_TABULATE_MAX_BYTES (std::size_t{1} << 20)
+#endif
+
+namespace pipet {
+namespace detail {
+// lookup-table adaptors for pure constexpr filters (or pipes) over a small
+// integral domain: the filter is evaluated over its whole input domain at
+// compile time, a call is then a single table load. Reversible filters get
+// the inverse table when their output domain is small as well.
+
+template <typename T>
+constexpr bool is_tabulable_v =
+    std::is_integral_v<T> && !std::is_same_v<T, bool> && sizeof(T) <= 2;
+
+template <typename T>
+constexpr std::size_t domain_size_v = std::size_t{1} << (8 * sizeof(T));
+
+// table index of a domain value (signed values wrap around)
+template <typename T> constexpr std::size_t domain_index(T v) {
+  return static_cast<std::size_t>(static_cast<std::make_unsigned_t<T>>(v));
+}
+
+template <typename F> struct tabulate_io {
+  using args_type = typename traits::filter_traits<F>::args_type;
+
+  static_assert(helpers::size_v<args_type> == 1,
+                "[-][pipet] only single input filters can be tabulated");
+
+  using arg_type = std::decay_t<helpers::front_t<args_type>>;
+  using ret_type = typename traits::filter_traits<F>::ret_type;
+
+  static_assert(is_tabulable_v<arg_type>,
+                "[-][pipet] only 8/16-bit integral inputs can be tabulated");
+
+  static constexpr bool is_reversible =
+      std::is_same_v<typename traits::filter_traits<F>::filter_type,
+                     filter_rev_proc>;
+
+  // the inverse table needs a small output domain
+  static constexpr bool has_inverse_table =
+      is_reversible && is_tabulable_v<ret_type>;
+
+  static constexpr std::size_t table_bytes =
+      domain_size_v<arg_type> * sizeof(ret_type) +
+      (has_inverse_table ? domain_size_v<ret_type> * sizeof(arg_type) : 0);
+};
+
+template <typename F> constexpr auto make_table() {
+  using io = tabulate_io<F>;
+  std::array<typename io::ret_type, domain_size_v<typename io::arg_type>>
+      res{};
+  for (std::size_t i = 0; i < res.size(); ++i) {
+    res[i] = F::process(static_cast<typename io::arg_type>(i));
+  }
+  return res;
+}
+
+template <typename F> struct inverse_table {
+  std::array<typename tabulate_io<F>::arg_type,
+             domain_size_v<typename tabulate_io<F>::ret_type>>
+      values{};
+  bool is_injective{true};
+  bool is_surjective{false};
+};
+
+// inversion of the forward table (values out of the filter image are left to
+// the filter reverse)
+template <typename F, typename Table>
+constexpr auto make_inverse_table(Table const &table) {
+  inverse_table<F> res{};
+  std::array<bool, domain_size_v<typename tabulate_io<F>::ret_type>> seen{};
+  std::size_t image_size = 0;
+  for (std::size_t i = 0; i < table.size(); ++i) {
+    auto const r = domain_index(table[i]);
+    res.is_injective = res.is_injective && !seen[r];
+    image_size += !seen[r];
+    seen[r] = true;
+    res.values[r] = static_cast<typename tabulate_io<F>::arg_type>(i);
+  }
+  res.is_surjective = image_size == seen.size();
+  return res;
+}
+
+// values of the filter image, empty for a surjective filter
+template <typename F, bool Surjective, typename Table>
+constexpr auto make_image_mask(Table const &table) {
+  std::array<bool, Surjective
+                       ? 0
+                       : domain_size_v<typename tabulate_io<F>::ret_type>>
+      res{};
+  if constexpr (!Surjective) {
+    for (std::size_t i = 0; i < table.size(); ++i) {
+      res[domain_index(table[i])] = true;
+    }
+  }
+  return res;
+}
+
+template <typename F, std::size_t MaxBytes> struct tabulate_impl {
+  using arg_type = typename tabulate_io<F>::arg_type;
+  using ret_type = typename tabulate_io<F>::ret_type;
+
+  static_assert(tabulate_io<F>::table_bytes <= MaxBytes,
+                "[-][pipet] lookup table too large");
+
+  static constexpr auto table = make_table<F>();
+
+  static constexpr ret_type process(arg_type arg) {
+    return table[domain_index(arg)];
+  }
+
+  static constexpr void process_batch(helpers::span<arg_type const> in,
+                                      helpers::span<ret_type> out) {
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      out[i] = table[domain_index(in[i])];
+    }
+  }
+};
+
+template <typename F, std::size_t MaxBytes,
+          bool = tabulate_io<F>::is_reversible,
+          bool = tabulate_io<F>::has_inverse_table>
+struct tabulate_rev_impl : tabulate_impl<F, MaxBytes> {};
+
+// large output domain, reverse is forwarded to the filter
+template <typename F, std::size_t MaxBytes>
+struct tabulate_rev_impl<F, MaxBytes, true, false>
+    : tabulate_impl<F, MaxBytes> {
+  using typename tabulate_impl<F, MaxBytes>::arg_type;
+  using typename tabulate_impl<F, MaxBytes>::ret_type;
+
+  static constexpr arg_type reverse(ret_type arg) { return F::reverse(arg); }
+};
+
+template <typename F, std::size_t MaxBytes>
+struct tabulate_rev_impl<F, MaxBytes, true, true>
+    : tabulate_impl<F, MaxBytes> {
+  using base_type = tabulate_impl<F, MaxBytes>;
+  using typename base_type::arg_type;
+  using typename base_type::ret_type;
+
+  static constexpr auto inverse = make_inverse_table<F>(base_type::table);
+
+  static_assert(inverse.is_injective,
+                "[-][pipet] reversible filter is not injective");
+
+  static constexpr auto in_image =
+      make_image_mask<F, inverse.is_surjective>(base_type::table);
+
+  static_assert(tabulate_io<F>::table_bytes + sizeof(in_image) <= MaxBytes,
+                "[-][pipet] lookup table too large");
+
+  // a value out of the filter image is reversed by the filter
+  static constexpr arg_type reverse(ret_type arg) {
+    auto const i = domain_index(arg);
+    if constexpr (inverse.is_surjective) {
+      return inverse.values[i];
+    } else {
+      return in_image[i] ? inverse.values[i] : F::reverse(arg);
+    }
+  }
+
+  static constexpr void reverse_batch(helpers::span<ret_type const> in,
+                                      helpers::span<arg_type> out) {
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      out[i] = reverse(in[i]);
+    }
+  }
+};
+} // namespace detail
+
+// filter (or pipe) F over a 8/16-bit integral input replaced by a lookup
+// table computed at compile time
+template <typename F, std::size_t MaxBytes = PIPET_TABULATE_MAX_BYTES>
+struct tabulate : detail::tabulate_rev_impl<F, MaxBytes> {};
+} // namespace pipet
\ No newline at end of file
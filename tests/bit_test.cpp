@@ -16,6 +16,9 @@
 
 #include "gtest/gtest.h"
 
+#include <random>
+#include <vector>
+
 using namespace pipet::extra;
 
 TEST(bit_test, main) {
@@ -40,12 +43,158 @@ TEST(bit_test, main) {
   EXPECT_EQ(bit_count(0b0), 0);
   EXPECT_EQ(bit_count(0b1), 1);
   EXPECT_EQ(bit_count(0b11111111), 8);
+  for (uint64_t const w :
+       {uint64_t{0}, ~uint64_t{0}, uint64_t{0x8000000000000001},
+        uint64_t{0x0123456789abcdef}}) {
+    EXPECT_EQ(bit_count(w), pipet::extra::detail::popcount_swar(w));
+  }
 
   EXPECT_EQ(stringify(0b0u), "0b00000000000000000000000000000000");
   EXPECT_EQ(stringify(0b10u), "0b00000000000000000000000000000010");
   EXPECT_EQ(stringify(0b1011u), "0b00000000000000000000000000001011");
 }
 
+namespace {
+// bitmap of n words with a given density of set bits (per 1024)
+std::vector<uint64_t> random_bitmap(std::size_t n, unsigned density,
+                                    unsigned seed) {
+  std::mt19937_64 gen{seed};
+  std::vector<uint64_t> res(n);
+  for (auto &w : res) {
+    for (int b = 0; b < 64; ++b) {
+      if (gen() % 1024 < density) {
+        w |= uint64_t{1} << b;
+      }
+    }
+  }
+  return res;
+}
+
+std::size_t naive_count(std::vector<uint64_t> const &bits) {
+  std::size_t res = 0;
+  for (auto const w : bits) {
+    for (int b = 0; b < 64; ++b) {
+      res += (w >> b) & 1;
+    }
+  }
+  return res;
+}
+
+constexpr std::size_t constexpr_bitmap_count() {
+  uint64_t const bits[3] = {0xff, 0, 0x8000000000000001};
+  return bit_count(bits);
+}
+} // namespace
+
+TEST(bit_test, word) {
+  static_assert(trailing_zeros(0) == 64 && trailing_zeros(1) == 0 &&
+                    trailing_zeros(0x8000000000000000) == 63,
+                "[-][bit_test] trailing_zeros failed");
+  static_assert(leading_zeros(0) == 64 && leading_zeros(1) == 63 &&
+                    leading_zeros(0x8000000000000000) == 0,
+                "[-][bit_test] leading_zeros failed");
+  static_assert(detail::popcount_swar(0xf0f0) == 8 &&
+                    detail::ctz_portable(0x100) == 8 &&
+                    detail::clz_portable(0x100) == 55,
+                "[-][bit_test] portable bit operations failed");
+  static_assert(constexpr_bitmap_count() == 10,
+                "[-][bit_test] bitmap bit_count failed");
+
+  for (auto const w : random_bitmap(1000, 512, 1)) {
+    EXPECT_EQ(bit_count(w), detail::popcount_swar(w));
+    if (w) {
+      EXPECT_EQ(trailing_zeros(w), detail::ctz_portable(w));
+      EXPECT_EQ(leading_zeros(w), detail::clz_portable(w));
+    }
+  }
+
+  EXPECT_EQ(stringify(uint8_t{0b101}), "0b00000101");
+  EXPECT_EQ(stringify(int8_t{-1}), "0b11111111");
+}
+
+TEST(bit_test, bitmap) {
+  for (std::size_t n : {0, 1, 3, 4, 63, 64, 65, 100, 1000, 4099}) {
+    auto const a = random_bitmap(n, 300, 2);
+    auto const b = random_bitmap(n, 700, 3);
+
+    std::vector<uint64_t> out(n), expected(n);
+    EXPECT_EQ(bit_count(a), naive_count(a));
+
+    for (std::size_t i = 0; i < n; ++i) {
+      expected[i] = a[i] & b[i];
+    }
+    bit_and(a, b, out);
+    EXPECT_EQ(out, expected);
+    EXPECT_EQ(bit_count_and(a, b), naive_count(expected));
+
+    for (std::size_t i = 0; i < n; ++i) {
+      expected[i] = a[i] | b[i];
+    }
+    bit_or(a, b, out);
+    EXPECT_EQ(out, expected);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      expected[i] = a[i] ^ b[i];
+    }
+    bit_xor(a, b, out);
+    EXPECT_EQ(out, expected);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      expected[i] = a[i] & ~b[i];
+    }
+    bit_andnot(a, b, out);
+    EXPECT_EQ(out, expected);
+
+    // in place
+    out = a;
+    bit_and(out, b, out);
+    EXPECT_EQ(bit_count(out), bit_count_and(a, b));
+  }
+
+#if PIPET_X86_SIMD
+  // every kernel available on this cpu
+  auto const a = random_bitmap(1003, 500, 4);
+  auto const b = random_bitmap(1003, 500, 5);
+  detail::plain_loader const plain{a.data()};
+  detail::word_loader<detail::and_op> const both{a.data(), b.data()};
+  auto const expected = detail::count_portable(plain, a.size());
+  auto const expected_and = detail::count_portable(both, a.size());
+
+  if (pipet::helpers::cpu().popcnt) {
+    EXPECT_EQ(detail::count_popcnt(plain, a.size()), expected);
+    EXPECT_EQ(detail::count_popcnt(both, a.size()), expected_and);
+  }
+  if (pipet::helpers::cpu().avx2) {
+    EXPECT_EQ(detail::count_avx2(plain, a.size()), expected);
+    EXPECT_EQ(detail::count_avx2(both, a.size()), expected_and);
+  }
+#endif
+}
+
+TEST(bit_test, iterate) {
+  std::vector<uint64_t> bits(5);
+  std::vector<std::size_t> const set = {0, 1, 63, 64, 200, 319};
+  for (auto const i : set) {
+    bits[i / 64] |= uint64_t{1} << (i % 64);
+  }
+
+  std::vector<std::size_t> visited;
+  for_each_set_bit(bits, [&](std::size_t i) { visited.push_back(i); });
+  EXPECT_EQ(visited, set);
+
+  visited.clear();
+  for (auto i = find_next_set(bits); i < 64 * bits.size();
+       i = find_next_set(bits, i + 1)) {
+    visited.push_back(i);
+  }
+  EXPECT_EQ(visited, set);
+
+  EXPECT_EQ(find_next_set(bits, 65), 200u);
+  EXPECT_EQ(find_next_set(bits, 320), 320u);
+  std::vector<uint64_t> const empty(3);
+  EXPECT_EQ(find_next_set(empty), 192u);
+}
+
 int bit_test(int argc, char *argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
   ::testing::FLAGS_gtest_filter = "bit_test*";
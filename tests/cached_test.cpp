@@ -0,0 +1,155 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "pipet/cached.h"
+#include "pipet/pipet.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace pipet;
+
+namespace {
+std::atomic<int> g_process_calls{0};
+std::atomic<int> g_reverse_calls{0};
+
+struct f_expensive {
+  static int process(int a) {
+    ++g_process_calls;
+    return a * 3;
+  }
+};
+
+struct f_expensive_rev {
+  static int process(int a) {
+    ++g_process_calls;
+    return a + 5;
+  }
+
+  static int reverse(int a) {
+    ++g_reverse_calls;
+    return a - 5;
+  }
+};
+
+struct f_rev1 {
+  static int process(int a) { return a + 1; }
+
+  static int reverse(int a) { return a - 1; }
+};
+
+struct f_add1 {
+  static int process(int a) { return a + 1; }
+};
+
+struct f_sum {
+  static int process(int a, int b) { return a + b; }
+};
+} // namespace
+
+TEST(cached_test, main) {
+  using c_t = cached<f_expensive, 16>;
+  static_assert(
+      std::is_same_v<traits::filter_traits<c_t>::filter_type, filter_proc>);
+
+  g_process_calls = 0;
+  for (int r = 0; r < 3; ++r) {
+    for (int i = 0; i < 8; ++i) {
+      EXPECT_EQ(c_t::process(i), 3 * i);
+    }
+  }
+  EXPECT_EQ(g_process_calls, 8);
+  EXPECT_EQ(c_t::stats().misses, 8u);
+  EXPECT_EQ(c_t::stats().hits, 16u);
+
+  c_t::clear();
+  EXPECT_EQ(c_t::stats().hits, 0u);
+
+  // test use in pipes and branches
+  using p_t = pipet::pipe<f_add1, c_t, f_add1>;
+  EXPECT_EQ(p_t::process(2), 10);
+  EXPECT_EQ(p_t::process(2), 10);
+  EXPECT_EQ(c_t::stats().hits, 1u);
+
+  using b_t = pipet::pipe<branches<c_t, f_add1>, f_sum>;
+  EXPECT_EQ(b_t::process(1), 5);
+}
+
+TEST(cached_test, reverse) {
+  using c_t = cached<f_expensive_rev, 4>;
+  static_assert(std::is_same_v<traits::filter_traits<c_t>::filter_type,
+                               filter_rev_proc>);
+
+  g_process_calls = 0;
+  g_reverse_calls = 0;
+
+  using p_t = pipet::pipe<c_t, f_rev1>;
+  for (int r = 0; r < 2; ++r) {
+    EXPECT_EQ(p_t::process(1), 7);
+    EXPECT_EQ(p_t::reverse(7), 1);
+  }
+  EXPECT_EQ(g_process_calls, 1);
+  EXPECT_EQ(g_reverse_calls, 1);
+  EXPECT_EQ(c_t::reverse_stats().hits, 1u);
+
+  // test capacity bound
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(c_t::process(i), i + 5);
+  }
+  EXPECT_EQ(g_process_calls, 10);
+  EXPECT_EQ(c_t::process(9), 14);
+  EXPECT_EQ(g_process_calls, 10);
+}
+
+TEST(cached_test, sharded) {
+  using c_t = sharded_cached<f_expensive, 64, 4>;
+
+  // fewer keys than capacity: one call per key, then no eviction
+  g_process_calls = 0;
+  for (int i = 0; i < 32; ++i) {
+    EXPECT_EQ(c_t::process(i), 3 * i);
+  }
+  EXPECT_EQ(g_process_calls, 32);
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 4; ++t) {
+    workers.emplace_back([] {
+      for (int i = 0; i < 32; ++i) {
+        EXPECT_EQ(c_t::process(i), 3 * i);
+      }
+    });
+  }
+
+  for (auto &w : workers) {
+    w.join();
+  }
+
+  // all threads share the same cache
+  auto const s = c_t::stats();
+  EXPECT_EQ(s.misses, 32u);
+  EXPECT_EQ(s.hits, 128u);
+  EXPECT_EQ(g_process_calls, 32);
+  EXPECT_EQ(c_t::process(5), 15);
+}
+
+int cached_test(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_filter = "cached_test*";
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "pipet/helpers/clock_cache.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pipet::helpers;
+
+namespace {
+// force every key into the same probe sequence
+struct collide_hash {
+  std::size_t operator()(int) const { return 7; }
+};
+} // namespace
+
+TEST(clock_cache_test, main) {
+  // test hit/miss accounting
+  clock_cache<int, std::string, 4> c;
+  EXPECT_EQ(c.capacity(), 4u);
+  EXPECT_EQ(c.find(1), nullptr);
+  c.insert(1, "one");
+  ASSERT_NE(c.find(1), nullptr);
+  EXPECT_EQ(*c.find(1), "one");
+  EXPECT_EQ(c.stats().hits, 2u);
+  EXPECT_EQ(c.stats().misses, 1u);
+
+  auto calls = 0;
+  auto twice = [&calls](int k) {
+    ++calls;
+    return std::to_string(2 * k);
+  };
+  EXPECT_EQ(c.get_or_compute(4, twice), "8");
+  EXPECT_EQ(c.get_or_compute(4, twice), "8");
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(c.size(), 2u);
+
+  // test clock eviction (referenced entries get a second chance)
+  c.clear();
+  EXPECT_EQ(c.size(), 0u);
+  EXPECT_EQ(c.stats().hits, 0u);
+  for (int i = 0; i < 4; ++i) {
+    c.insert(i, std::to_string(i));
+  }
+  EXPECT_NE(c.find(0), nullptr);
+  c.insert(4, "4");
+  EXPECT_EQ(c.size(), 4u);
+  EXPECT_NE(c.find(0), nullptr);
+  EXPECT_EQ(c.find(1), nullptr);
+  EXPECT_NE(c.find(4), nullptr);
+
+  // test colliding keys survive backward shift deletion
+  clock_cache<int, int, 8, collide_hash> cc;
+  for (int i = 0; i < 100; ++i) {
+    cc.insert(i, i * i);
+    for (int j = (i > 7 ? i - 7 : 0); j <= i; ++j) {
+      ASSERT_NE(cc.find(j), nullptr);
+      EXPECT_EQ(*cc.find(j), j * j);
+    }
+  }
+  EXPECT_EQ(cc.size(), 8u);
+}
+
+TEST(clock_cache_test, sharded) {
+  sharded_clock_cache<int, int, 256, 4> c;
+
+  // fewer keys than capacity: one miss per key, then no eviction
+  constexpr int count = 128;
+  for (int i = 0; i < count; ++i) {
+    auto const v = c.get_or_compute(i, [](int k) { return k + 1; });
+    EXPECT_EQ(v, i + 1);
+  }
+  EXPECT_EQ(c.stats().misses, static_cast<std::size_t>(count));
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 4; ++t) {
+    workers.emplace_back([&c] {
+      for (int i = 0; i < count; ++i) {
+        auto const v = c.get_or_compute(i, [](int k) { return k + 1; });
+        EXPECT_EQ(v, i + 1);
+      }
+    });
+  }
+
+  for (auto &w : workers) {
+    w.join();
+  }
+
+  auto const s = c.stats();
+  EXPECT_EQ(s.misses, static_cast<std::size_t>(count));
+  EXPECT_EQ(s.hits, 4u * count);
+
+  c.clear();
+  EXPECT_EQ(c.stats().hits, 0u);
+}
+
+int clock_cache_test(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_filter = "clock_cache_test*";
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,182 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pipet/pipet.h"
+
+#include "gtest/gtest.h"
+
+#include <array>
+
+using namespace pipet;
+
+//-------------------------------------
+// Utility
+
+namespace {
+// payload counting its copies and moves
+struct counted {
+  static inline std::size_t copies = 0;
+  static inline std::size_t moves = 0;
+
+  static void reset() { copies = moves = 0; }
+
+  std::array<int, 256> data{};
+
+  counted() = default;
+  counted(counted const &o) : data{o.data} { ++copies; }
+  counted(counted &&o) noexcept : data{o.data} { ++moves; }
+  counted &operator=(counted const &o) {
+    data = o.data;
+    ++copies;
+    return *this;
+  }
+  counted &operator=(counted &&o) noexcept {
+    data = o.data;
+    ++moves;
+    return *this;
+  }
+};
+
+// stage taking its input by value (moves it to its output)
+struct by_value_filter {
+  static counted process(counted c) {
+    ++c.data[0];
+    return c;
+  }
+
+  static counted reverse(counted c) {
+    --c.data[0];
+    return c;
+  }
+};
+
+// stage reading its input by reference (builds a new output)
+struct by_ref_filter {
+  static counted process(counted const &c) {
+    counted res;
+    res.data[0] = c.data[0] + 1;
+    return res;
+  }
+
+  static counted reverse(counted const &c) {
+    counted res;
+    res.data[0] = c.data[0] - 1;
+    return res;
+  }
+};
+
+template <std::size_t, typename T> using always_t = T;
+
+template <typename F, std::size_t... Is>
+using repeat_pipe_t = pipet::pipe<always_t<Is, F>...>;
+
+template <typename F, std::size_t... Is>
+auto make_pipe(std::index_sequence<Is...>) -> repeat_pipe_t<F, Is...>;
+
+template <typename F>
+using pipe10_t = decltype(make_pipe<F>(std::make_index_sequence<10>{}));
+
+template <typename F> counted hand_written(counted const &c) {
+  return F::process(F::process(F::process(F::process(F::process(F::process(
+      F::process(F::process(F::process(F::process(c))))))))));
+}
+
+template <typename F> counted hand_written_rev(counted const &c) {
+  return F::reverse(F::reverse(F::reverse(F::reverse(F::reverse(F::reverse(
+      F::reverse(F::reverse(F::reverse(F::reverse(c))))))))));
+}
+
+struct counts {
+  std::size_t copies;
+  std::size_t moves;
+};
+
+template <typename Fn> counts count(Fn fn) {
+  counted::reset();
+  fn();
+  return {counted::copies, counted::moves};
+}
+} // namespace
+
+//-------------------------------------
+// Dynamic Tests
+
+TEST(forwarding_test, main) {
+  // test params type is kept as declared
+  static_assert(std::is_same_v<helpers::typelist<counted const &>,
+                               traits::filter_traits<by_ref_filter>::params_type>,
+                "[-][forwarding_test] params_type failed");
+  static_assert(std::is_same_v<helpers::typelist<counted>,
+                               traits::filter_traits<by_ref_filter>::args_type>,
+                "[-][forwarding_test] args_type failed");
+
+  counted const input{};
+  counted const output = hand_written<by_value_filter>(input);
+
+  // test results
+  EXPECT_EQ(pipe10_t<by_value_filter>::process(input).data[0], 10);
+  EXPECT_EQ(pipe10_t<by_ref_filter>::process(input).data[0], 10);
+  EXPECT_EQ(pipe10_t<by_value_filter>::reverse(output).data[0], 0);
+  EXPECT_EQ(pipe10_t<by_ref_filter>::reverse(output).data[0], 0);
+
+  // reference filters: no copy/move added by the pipe at all
+  auto const ref_hand = count([&] { return hand_written<by_ref_filter>(input); });
+  auto const ref_pipe =
+      count([&] { return pipe10_t<by_ref_filter>::process(input); });
+  EXPECT_EQ(ref_pipe.copies, ref_hand.copies);
+  EXPECT_EQ(ref_pipe.moves, ref_hand.moves);
+
+  auto const ref_rev_hand =
+      count([&] { return hand_written_rev<by_ref_filter>(output); });
+  auto const ref_rev_pipe =
+      count([&] { return pipe10_t<by_ref_filter>::reverse(output); });
+  EXPECT_EQ(ref_rev_pipe.copies, ref_rev_hand.copies);
+  EXPECT_EQ(ref_rev_pipe.moves, ref_rev_hand.moves);
+
+  // value filters: stage outputs are handed over as prvalues, only the pipe
+  // entry parameter is moved once into the first filter whatever the length
+  auto const val_hand =
+      count([&] { return hand_written<by_value_filter>(input); });
+  auto const val_pipe =
+      count([&] { return pipe10_t<by_value_filter>::process(input); });
+  EXPECT_EQ(val_pipe.copies, val_hand.copies);
+  EXPECT_EQ(val_pipe.moves, val_hand.moves + 1);
+
+  auto const val_hand1 = count([&] { return by_value_filter::process(input); });
+  auto const val_pipe1 =
+      count([&] { return pipet::pipe<by_value_filter>::process(input); });
+  EXPECT_EQ(val_pipe1.copies, val_hand1.copies);
+  EXPECT_EQ(val_pipe1.moves, val_hand1.moves + 1);
+
+  auto const val_rev_hand =
+      count([&] { return hand_written_rev<by_value_filter>(output); });
+  auto const val_rev_pipe =
+      count([&] { return pipe10_t<by_value_filter>::reverse(output); });
+  EXPECT_EQ(val_rev_pipe.copies, val_rev_hand.copies);
+  EXPECT_EQ(val_rev_pipe.moves, val_rev_hand.moves + 1);
+
+  // nested pipes are fed without materializing their input
+  using nested_t = pipet::pipe<pipe10_t<by_ref_filter>, pipe10_t<by_ref_filter>>;
+  EXPECT_EQ(nested_t::process(input).data[0], 20);
+  auto const nested = count([&] { return nested_t::process(input); });
+  EXPECT_EQ(nested.copies, 0u);
+  EXPECT_EQ(nested.moves, 0u);
+}
+
+int forwarding_test(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_filter = "forwarding_test*";
+
+  return RUN_ALL_TESTS();
+}
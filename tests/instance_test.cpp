@@ -0,0 +1,132 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pipet/instance.h"
+#include "pipet/pipet.h"
+#include "test_common.h"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <memory>
+
+using namespace pipet;
+using namespace pipet::test;
+
+//-------------------------------------
+// Utility
+
+namespace {
+// stateful reversible filter
+struct scale_filter {
+  int factor{1};
+
+  constexpr int process(int a) const { return a * factor; }
+
+  constexpr int reverse(int a) const { return a / factor; }
+};
+
+// filter with an expensive setup (lookup table built from runtime config)
+struct table_filter {
+  static inline int setups = 0;
+
+  std::array<int, 16> table{};
+
+  table_filter() = default;
+
+  explicit table_filter(int offset) {
+    ++setups;
+    for (int i = 0; i < 16; ++i) {
+      table[i] = i + offset;
+    }
+  }
+
+  int process(int a) const { return table[a & 0xF]; }
+};
+
+// filter mutating its state
+struct counter_filter {
+  int calls{0};
+
+  int process(int a) {
+    ++calls;
+    return a;
+  }
+};
+} // namespace
+
+//-------------------------------------
+// Dynamic Tests
+
+TEST(instance_test, main) {
+  // test trait for non-static filters
+  static_assert(
+      std::is_same_v<traits::filter_traits<scale_filter>::filter_type,
+                     filter_rev_proc>,
+      "[-][instance_test] trait instantiation failed");
+  static_assert(std::is_same_v<traits::filter_traits<counter_filter>::args_type,
+                               helpers::typelist<int>>,
+                "[-][instance_test] trait instantiation failed");
+
+  // test compile-time instance mixing stateful and stateless filters
+  constexpr pipe_instance<f1_rev_proc_ct, scale_filter, scale_filter> scaler{
+      {}, scale_filter{2}, scale_filter{3}};
+  static_assert(scaler.process(2) == 12,
+                "[-][instance_test] instance processing failed");
+  static_assert(scaler.reverse(12) == 2,
+                "[-][instance_test] instance reversing failed");
+
+  // test generator and nested static pipe
+  constexpr pipe_instance<fo_gen_ct, scale_filter,
+                          pipet::pipe<f2_rev_proc_ct, f3_rev_proc_ct>>
+      gen{{}, scale_filter{5}, {}};
+  static_assert(gen.process() == std::tuple<int, int>{6, 6},
+                "[-][instance_test] instance processing failed");
+
+  // test branches
+  using branch1_t = pipet::pipe<f1_proc_ct, f_square_ct>;
+  constexpr pipe_instance<
+      scale_filter,
+      pipet::branches<pipet::placeholders::self, branch1_t, f_cube_ct>,
+      f_add3_ct>
+      br{scale_filter{2}, {}, {}};
+  static_assert(br.process(1) == 14,
+                "[-][instance_test] instance processing failed");
+
+  // test setup paid once per instance
+  pipe_instance<table_filter, counter_filter, scale_filter> inst{
+      table_filter{10}, counter_filter{}, scale_filter{2}};
+  EXPECT_EQ(table_filter::setups, 1);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(inst.process(i), 2 * ((i & 0xF) + 10));
+  }
+  EXPECT_EQ(table_filter::setups, 1);
+  EXPECT_EQ(inst.get<1>().calls, 100);
+
+  // test move only input
+  pipe_instance<f1_proc_rt, scale_filter> rt{{}, scale_filter{3}};
+  EXPECT_EQ(rt.process(std::make_unique<int>(2)), 6);
+
+  // test class template argument deduction
+  pipe_instance deduced{scale_filter{4}, f1_rev_proc_ct{}};
+  EXPECT_EQ(deduced.process(2), 8);
+  EXPECT_EQ(deduced.reverse(8), 2);
+}
+
+int instance_test(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_filter = "instance_test*";
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,228 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pipet/optimize.h"
+#include "pipet/pipet.h"
+#include "test_common.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+using namespace pipet;
+using namespace pipet::test;
+
+namespace {
+struct f_decode;
+
+struct f_encode {
+  using inverse_type = f_decode;
+
+  static inline int calls = 0;
+
+  static int process(int a) {
+    ++calls;
+    return a * 3 + 1;
+  }
+
+  static int reverse(int a) { return (a - 1) / 3; }
+};
+
+struct f_decode {
+  static int process(int a) { return f_encode::reverse(a); }
+
+  static int reverse(int a) { return f_encode::process(a); }
+};
+
+struct f_negate {
+  using inverse_type = f_negate;
+
+  static constexpr int process(int a) { return -a; }
+
+  static constexpr int reverse(int a) { return -a; }
+};
+
+template <uint8_t K> struct f_xor_key {
+  static constexpr uint8_t process(uint8_t a) {
+    return static_cast<uint8_t>(a ^ K);
+  }
+
+  static constexpr uint8_t reverse(uint8_t a) {
+    return static_cast<uint8_t>(a ^ K);
+  }
+};
+
+struct add_group;
+
+template <int K> struct f_add_const {
+  using commute_group = add_group;
+
+  static constexpr int process(int a) { return a + K; }
+
+  static constexpr int reverse(int a) { return a - K; }
+};
+
+// same group, more expensive
+struct f_add_slow {
+  using commute_group = add_group;
+  static constexpr std::size_t cost = 10;
+
+  static constexpr int process(int a) {
+    int res = a;
+    for (int i = 0; i < 100; ++i) {
+      res += (i == 99);
+    }
+    return res;
+  }
+
+  static constexpr int reverse(int a) { return a - 1; }
+};
+
+// pipe of N times the filter F
+template <std::size_t, typename T> using always_t = T;
+
+template <typename F, std::size_t... Is>
+pipet::pipe<always_t<Is, F>...> make_repeat_pipe(std::index_sequence<Is...>);
+
+template <typename F, std::size_t N>
+using repeat_pipe_t =
+    decltype(make_repeat_pipe<F>(std::make_index_sequence<N>{}));
+} // namespace
+
+namespace pipet::traits {
+template <uint8_t A, uint8_t B> struct compose<f_xor_key<A>, f_xor_key<B>> {
+  using type = std::conditional_t<A == B, placeholders::self,
+                                  f_xor_key<static_cast<uint8_t>(A ^ B)>>;
+};
+
+template <int A, int B> struct compose<f_add_const<A>, f_add_const<B>> {
+  using type = f_add_const<A + B>;
+};
+} // namespace pipet::traits
+
+TEST(optimize_test, inverse_pairs) {
+  // declared inverse pair removed
+  using p1_t = pipet::pipe<f1_proc_ct, f_encode, f_decode, f_square_ct>;
+  static_assert(std::is_same_v<p1_t::filters_type,
+                               helpers::typelist<f1_proc_ct, f_square_ct>>,
+                "[-][optimize_test] inverse pair not removed");
+
+  f_encode::calls = 0;
+  EXPECT_EQ(p1_t::process(3), 9);
+  EXPECT_EQ(f_encode::calls, 0);
+
+  // nested pairs cancel in cascade, involution and inverse adaptor
+  using p2_t = pipet::pipe<f1_rev_proc_ct, f_encode, f_negate, f_negate,
+                           pipet::inverse<f_encode>, f_negate>;
+  static_assert(std::is_same_v<p2_t::filters_type,
+                               helpers::typelist<f1_rev_proc_ct, f_negate>>,
+                "[-][optimize_test] inverse pairs not removed");
+  EXPECT_EQ(p2_t::process(5), -5);
+  EXPECT_EQ(p2_t::reverse(-5), 5);
+
+  // pipe reduced to nothing passes its input through
+  using p3_t = pipet::pipe<f_encode, f_negate, f_negate, f_decode>;
+  static_assert(helpers::size_v<p3_t::filters_type> == 1,
+                "[-][optimize_test] identity pipe expected");
+  EXPECT_EQ(p3_t::process(12), 12);
+  EXPECT_EQ(p3_t::reverse(12), 12);
+
+  // unmatched adaptor still reverses the filter
+  EXPECT_EQ(pipet::pipe<pipet::inverse<f_encode>>::process(10), 3);
+
+  // reverse order kept: f_encode does not undo f_decode
+  using p4_t = pipet::pipe<f_decode, f_encode>;
+  static_assert(helpers::size_v<p4_t::filters_type> == 2,
+                "[-][optimize_test] reversed pair removed");
+  EXPECT_EQ(p4_t::process(5), 4);
+
+  using p5_t = pipet::pipe<pipet::inverse<f_encode>, f_encode>;
+  static_assert(helpers::size_v<p5_t::filters_type> == 2,
+                "[-][optimize_test] reversed adaptor pair removed");
+  EXPECT_EQ(p5_t::process(5), 4);
+
+  // long pipes (more stages than a fold chunk)
+  using p6_t = repeat_pipe_t<f_negate, 301>;
+  static_assert(
+      std::is_same_v<p6_t::filters_type, helpers::typelist<f_negate>>,
+      "[-][optimize_test] long inverse pairs not removed");
+  EXPECT_EQ(p6_t::process(5), -5);
+
+  using p7_t = repeat_pipe_t<f1_proc_ct, 300>;
+  static_assert(helpers::size_v<p7_t::filters_type> == 300,
+                "[-][optimize_test] long pipe optimized");
+  EXPECT_EQ(p7_t::process(7), 7);
+}
+
+TEST(optimize_test, compose) {
+  using p1_t = pipet::pipe<f_xor_key<0x01>, f_xor_key<0x02>, f_xor_key<0x04>>;
+  static_assert(
+      std::is_same_v<p1_t::filters_type, helpers::typelist<f_xor_key<0x07>>>,
+      "[-][optimize_test] filters not composed");
+  static_assert(p1_t::process(0x10) == 0x17,
+                "[-][optimize_test] composed pipe processing failed");
+  static_assert(p1_t::reverse(0x17) == 0x10,
+                "[-][optimize_test] composed pipe reversing failed");
+
+  // composition cancelling out
+  using p2_t = pipet::pipe<f_negate, f_xor_key<0x05>, f_xor_key<0x05>>;
+  static_assert(
+      std::is_same_v<p2_t::filters_type, helpers::typelist<f_negate>>,
+      "[-][optimize_test] composed filters not cancelled");
+}
+
+TEST(optimize_test, reorder) {
+  // cheapest first, cheap filters brought together are composed
+  using p_t = pipet::pipe<f_add_const<1>, f_add_slow, f_add_const<2>>;
+  static_assert(std::is_same_v<p_t::filters_type,
+                               helpers::typelist<f_add_const<3>, f_add_slow>>,
+                "[-][optimize_test] commuting filters not reordered");
+  static_assert(p_t::process(1) == 5,
+                "[-][optimize_test] reordered pipe processing failed");
+  static_assert(p_t::reverse(5) == 1,
+                "[-][optimize_test] reordered pipe reversing failed");
+
+  // no group, no reordering
+  using q_t = pipet::pipe<f_add_slow, f_negate>;
+  static_assert(std::is_same_v<q_t::filters_type,
+                               helpers::typelist<f_add_slow, f_negate>>,
+                "[-][optimize_test] filters reordered");
+}
+
+TEST(optimize_test, branches) {
+  // fan-out is a barrier, branch pipes are optimized
+  using branch_t = pipet::pipe<f_negate, f_square_ct, f_negate, f_negate>;
+  using p_t = pipet::pipe<
+      f_negate,
+      pipet::branches<pipet::placeholders::self, branch_t, f_cube_ct>,
+      f_add3_ct, f_negate>;
+  static_assert(helpers::size_v<p_t::filters_type> == 4,
+                "[-][optimize_test] fan-out optimized");
+  static_assert(
+      std::is_same_v<branch_t::filters_type,
+                     helpers::typelist<f_negate, f_square_ct>>,
+      "[-][optimize_test] branch not optimized");
+
+  // y = -(-2 + 4 + -8)
+  EXPECT_EQ(p_t::process(2), 6);
+}
+
+int optimize_test(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_filter = "optimize_test*";
+
+  return RUN_ALL_TESTS();
+}
\ No newline at end of file
@@ -12,16 +12,100 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "pipet/helpers/cpu.h"
 #include "pipet/pipet.h"
 #include "test_common.h"
 
 #include "gtest/gtest.h"
 
+#include <array>
+#include <stdexcept>
 #include <tuple>
+#include <vector>
 
 using namespace pipet;
 using namespace pipet::test;
 
+namespace {
+// filter providing its own block routine
+struct f_twice_batch_ct {
+  static inline std::size_t batch_calls = 0;
+
+  static constexpr auto process(int a) { return 2 * a; }
+
+  static constexpr auto reverse(int a) { return a / 2; }
+
+  static void process_batch(helpers::span<int const> in,
+                            helpers::span<int> out) {
+    ++batch_calls;
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      out[i] = 2 * in[i];
+    }
+  }
+};
+
+// branch running on a worker thread
+struct f_throw_rt {
+  static int process(int a) {
+    if (a < 0) {
+      throw std::invalid_argument("negative input");
+    }
+    return a;
+  }
+};
+
+// stage of a generated long pipe
+template <std::size_t I> struct f_step_ct {
+  static constexpr int process(int a) { return a + static_cast<int>(I % 3); }
+
+  static constexpr int reverse(int a) { return a - static_cast<int>(I % 3); }
+};
+
+// stage counting its runtime calls only
+struct f_count_ct {
+  static inline int calls = 0;
+
+  static constexpr int process(int a) {
+    if (!helpers::is_constant_evaluated()) {
+      ++calls;
+    }
+    return a + 1;
+  }
+};
+
+// runtime only stage
+struct f_twice_rt {
+  static int process(int a) { return 2 * a; }
+};
+
+// add 2 different inputs
+struct f_add2_ct {
+  static constexpr auto process(int a, int b) { return a + b; }
+};
+
+template <std::size_t... Is, typename... Fs>
+auto make_long_pipe(std::index_sequence<Is...>, Fs...)
+    -> pipet::pipe<f_step_ct<Is>..., Fs...>;
+
+// several chunks long, instantiation must not nest per filter
+template <std::size_t N>
+using long_pipe_t = decltype(make_long_pipe(std::make_index_sequence<N>{}));
+
+template <std::size_t... Is, typename... Fs>
+auto make_gen_pipe(std::index_sequence<Is...>, Fs...)
+    -> pipet::pipe<fo_gen_ct, f_step_ct<Is>..., Fs...>;
+
+template <std::size_t N, typename... Fs>
+using gen_pipe_t =
+    decltype(make_gen_pipe(std::make_index_sequence<N>{}, Fs{}...));
+
+constexpr auto batch_square(std::array<int, 4> const &in) {
+  std::array<int, 4> out{};
+  pipet::pipe<f1_proc_ct, f_square_ct>::process_batch(in, out);
+  return out;
+}
+} // namespace
+
 TEST(pipet_test, main) {
   // test pipe building and running
   static_assert(
@@ -94,6 +178,214 @@ TEST(pipet_test, main) {
   EXPECT_EQ((pipet::pipe<fo_gen_rt, f1_proc_rt>::process()), 1);
 }
 
+TEST(pipet_test, batch) {
+  // test batch processing at compile-time
+  static_assert(batch_square({1, 2, 3, 4})[3] == 16,
+                "[-][pipet_test] pipe batch processing failed");
+
+  // test batch processing with filter fallback and filter batch routine
+  using batch_pipe_t = pipet::pipe<f1_rev_proc_ct, f_twice_batch_ct>;
+  std::vector<int> in(10000);
+  std::vector<int> out(in.size());
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    in[i] = static_cast<int>(i);
+  }
+
+  batch_pipe_t::process_batch(in, out);
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    EXPECT_EQ(out[i], batch_pipe_t::process(in[i]));
+  }
+  EXPECT_EQ(f_twice_batch_ct::batch_calls,
+            (in.size() + detail::batch_block_size<int> - 1) /
+                detail::batch_block_size<int>);
+
+  // test batch reversing
+  std::vector<int> rev(in.size());
+  batch_pipe_t::reverse_batch(out, rev);
+  EXPECT_EQ(rev, in);
+
+  // test batch processing with branches
+  using branch1_t = pipet::pipe<f1_proc_ct, f_square_ct>;
+  using pipe_branches_t = pipet::pipe<
+      f1_proc_ct,
+      pipet::branches<pipet::placeholders::self, branch1_t, f_cube_ct>,
+      f_add3_ct>;
+  std::array<int, 3> const bin{1, 2, 3};
+  std::array<int, 3> bout{};
+  pipe_branches_t::process_batch(bin, bout);
+  EXPECT_EQ(bout, (std::array<int, 3>{3, 14, 39}));
+}
+
+TEST(pipet_test, gen_prefix) {
+  // whole pipe folded
+  using folded_t = pipet::pipe<fo_gen_ct, f_count_ct, f2_rev_proc_ct,
+                               f3_rev_proc_ct>;
+  static_assert(folded_t::folded_filters == 4,
+                "[-][pipet_test] generator prefix folding failed");
+  EXPECT_EQ(folded_t::process(), (std::tuple<int, int>{3, 3}));
+
+  // prefix folded up to the first runtime stage
+  using prefix_t = pipet::pipe<fo_gen_ct, f_count_ct, f_count_ct, f_twice_rt,
+                               f_count_ct>;
+  static_assert(prefix_t::folded_filters == 3,
+                "[-][pipet_test] generator prefix folding failed");
+  f_count_ct::calls = 0;
+  EXPECT_EQ(prefix_t::process(), 7);
+  EXPECT_EQ(prefix_t::process(), 7);
+  EXPECT_EQ(f_count_ct::calls, 2);
+
+  // branches folded with their consumer
+  using branch1_t = pipet::pipe<f1_proc_ct, f_square_ct>;
+  using branches_t = pipet::pipe<
+      fo_gen_ct, f_count_ct,
+      pipet::branches<pipet::placeholders::self, branch1_t, f_cube_ct>,
+      f_add3_ct, f_twice_rt>;
+  static_assert(branches_t::folded_filters == 4,
+                "[-][pipet_test] generator prefix folding failed");
+  EXPECT_EQ(branches_t::process(), 28);
+
+  // runtime generator, nothing folded
+  using runtime_t = pipet::pipe<fo_gen_rt, f1_proc_rt, f_count_ct>;
+  static_assert(runtime_t::folded_filters == 0,
+                "[-][pipet_test] generator prefix folding failed");
+  f_count_ct::calls = 0;
+  EXPECT_EQ(runtime_t::process(), 2);
+  EXPECT_EQ(f_count_ct::calls, 1);
+
+  // prefixes over several chunks, walked chunk by chunk then slot by slot
+  static_assert(gen_pipe_t<300>::folded_filters == 301,
+                "[-][pipet_test] long generator prefix folding failed");
+  static_assert(gen_pipe_t<300>::process() == 301,
+                "[-][pipet_test] long generator pipe processing failed");
+
+  using long_prefix_t = gen_pipe_t<70, f_twice_rt, f_count_ct>;
+  static_assert(long_prefix_t::folded_filters == 71,
+                "[-][pipet_test] long generator prefix folding failed");
+  EXPECT_EQ(long_prefix_t::process(), 141);
+}
+
+TEST(pipet_test, shared_branches) {
+  // duplicate branches run once (y = x*x + x*x + x*x*x)
+  using branch1_t = pipet::pipe<f_count_ct, f_square_ct>;
+  using branch2_t = pipet::pipe<f_count_ct, f_cube_ct>;
+  using dup_t =
+      pipet::pipe<f1_proc_ct, pipet::branches<branch1_t, branch1_t, branch2_t>,
+                  f_add3_ct>;
+  static_assert(dup_t::process(2) == 45,
+                "[-][pipet_test] shared branches processing failed");
+
+  f_count_ct::calls = 0;
+  EXPECT_EQ(dup_t::process(2), 45);
+  EXPECT_EQ(f_count_ct::calls, 1);
+
+  // common prefix of branches run once, direct branch untouched
+  using prefix1_t = pipet::pipe<f_count_ct, f_count_ct, f_square_ct>;
+  using prefix2_t = pipet::pipe<f_count_ct, f_count_ct, f_cube_ct>;
+  using prefix_t = pipet::pipe<
+      f1_proc_ct,
+      pipet::branches<prefix1_t, pipet::placeholders::self, prefix2_t>,
+      f_add3_ct>;
+
+  f_count_ct::calls = 0;
+  EXPECT_EQ(prefix_t::process(1), 9 + 1 + 27);
+  EXPECT_EQ(f_count_ct::calls, 2);
+
+  // batch processing goes through the same stage
+  std::array<int, 3> const in{1, 2, 3};
+  std::array<int, 3> out{};
+  f_count_ct::calls = 0;
+  prefix_t::process_batch(in, out);
+  EXPECT_EQ(out, (std::array<int, 3>{37, 82, 153}));
+  EXPECT_EQ(f_count_ct::calls, 6);
+
+  // distinct heads are not shared
+  static_assert(
+      !detail::shared_branches_t<branch1_t, f_cube_ct,
+                                 placeholders::self>::groups::is_shared(),
+      "[-][pipet_test] shared branches detection failed");
+}
+
+TEST(pipet_test, long_pipe) {
+  // sum of I % 3 for I in [0, 300)
+  static_assert(long_pipe_t<300>::process(0) == 300,
+                "[-][pipet_test] long pipe processing failed");
+  static_assert(long_pipe_t<300>::reverse(300) == 0,
+                "[-][pipet_test] long pipe reversing failed");
+
+  // test branches and nested pipes across chunk boundaries
+  using branch1_t = pipet::pipe<f1_proc_ct, f_square_ct>;
+  using long_branches_t = decltype(make_long_pipe(
+      std::make_index_sequence<31>{},
+      pipet::branches<pipet::placeholders::self, branch1_t>{}, f_add2_ct{},
+      long_pipe_t<40>{}));
+  // 30 + 30 * 30 + 39
+  static_assert(long_branches_t::process(0) == 969,
+                "[-][pipet_test] long pipe processing failed");
+
+  std::vector<int> in(100);
+  std::vector<int> out(in.size());
+  std::vector<int> rev(in.size());
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    in[i] = static_cast<int>(i);
+  }
+
+  long_pipe_t<300>::process_batch(in, out);
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    EXPECT_EQ(out[i], in[i] + 300);
+  }
+  long_pipe_t<300>::reverse_batch(out, rev);
+  EXPECT_EQ(rev, in);
+
+  long_branches_t::process_batch(in, out);
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    EXPECT_EQ(out[i], long_branches_t::process(in[i]));
+  }
+}
+
+TEST(pipet_test, par_branches) {
+  using branch1_t = pipet::pipe<f1_proc_ct, f_square_ct>;
+  using branch2_t = pipet::pipe<f_cube_ct, f1_proc_ct>;
+
+  // test parallel branching with no direct branch (y = x*x + x*x + x*x*x)
+  using pipe_branches_2_t = pipet::pipe<
+      f1_proc_ct, pipet::par_branches<branch1_t, branch1_t, branch2_t>,
+      f_add3_ct>;
+  EXPECT_EQ(pipe_branches_2_t::process(2), 16);
+
+  // test parallel branching with direct branch (y = x + x*x + x*x*x)
+  using pipe_branches_3_t = pipet::pipe<
+      f1_proc_ct,
+      pipet::par_branches<pipet::placeholders::self, branch1_t, branch2_t>,
+      f_add3_ct>;
+  EXPECT_EQ(pipe_branches_3_t::process(2), 14);
+
+  // test single heavy branch (run inline)
+  using pipe_branches_4_t =
+      pipet::pipe<f1_proc_ct,
+                  pipet::par_branches<branch1_t, pipet::placeholders::self,
+                                      pipet::placeholders::self>,
+                  f_add3_ct>;
+  EXPECT_EQ(pipe_branches_4_t::process(2), 8);
+
+  // test many calls and batch
+  std::vector<int> in(1000);
+  std::vector<int> out(in.size());
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    in[i] = static_cast<int>(i % 100);
+  }
+  pipe_branches_3_t::process_batch(in, out);
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    EXPECT_EQ(out[i], in[i] + in[i] * in[i] + in[i] * in[i] * in[i]);
+  }
+
+  // test failure propagation from a worker branch
+  using pipe_branches_5_t = pipet::pipe<
+      f1_proc_ct, pipet::par_branches<branch1_t, f_throw_rt, f_throw_rt>,
+      f_add3_ct>;
+  EXPECT_EQ(pipe_branches_5_t::process(2), 8);
+  EXPECT_THROW(pipe_branches_5_t::process(-2), std::invalid_argument);
+}
+
 int pipet_test(int argc, char *argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
   ::testing::FLAGS_gtest_filter = "pipet_test*";
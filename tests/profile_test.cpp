@@ -0,0 +1,218 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pipet/pipet.h"
+#include "pipet/profile.h"
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <thread>
+
+using namespace pipet;
+
+//-------------------------------------
+// Utility
+
+namespace {
+struct p_add1 {
+  static int process(int a) { return a + 1; }
+
+  static int reverse(int a) { return a - 1; }
+};
+
+struct p_twice {
+  static int process(int a) { return 2 * a; }
+
+  static int reverse(int a) { return a / 2; }
+};
+
+struct p_square {
+  static int process(int a) { return a * a; }
+};
+
+struct p_sum {
+  static int process(int a, int b) { return a + b; }
+};
+
+// optimization traits (optimize.h)
+struct p_negate {
+  using inverse_type = p_negate;
+
+  static constexpr int process(int a) { return -a; }
+
+  static constexpr int reverse(int a) { return -a; }
+};
+
+struct shift_group;
+
+template <int K> struct p_shift {
+  using commute_group = shift_group;
+
+  static constexpr int process(int a) { return a + K; }
+
+  static constexpr int reverse(int a) { return a - K; }
+};
+
+struct p_shift_slow {
+  using commute_group = shift_group;
+  static constexpr std::size_t cost = 10;
+
+  static constexpr int process(int a) { return a + 1; }
+
+  static constexpr int reverse(int a) { return a - 1; }
+};
+
+struct p_batch {
+  static int process(int a) { return a + 3; }
+
+  static void process_batch(helpers::span<int const> in,
+                            helpers::span<int> out) {
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      out[i] = in[i] + 3;
+    }
+  }
+};
+
+template <typename F> profile_stats stats_of(std::string_view path) {
+  for (auto const &e : profiler::report()) {
+    if (e.filter == helpers::type_name<F>() && e.path == path) {
+      return e.stats;
+    }
+  }
+  return {};
+}
+} // namespace
+
+namespace pipet::traits {
+template <int A, int B> struct compose<p_shift<A>, p_shift<B>> {
+  using type = p_shift<A + B>;
+};
+} // namespace pipet::traits
+
+//-------------------------------------
+// Dynamic Tests
+
+TEST(profile_test, main) {
+  using plain_t = pipet::pipe<p_add1, p_twice>;
+  using profiled_t = pipet::pipe<profile, p_add1, p_twice>;
+
+  static_assert(
+      std::is_same_v<traits::filter_traits<profiled<p_add1>>::filter_type,
+                     filter_rev_proc>,
+      "[-][profile_test] profiled traits failed");
+  static_assert(
+      std::is_same_v<traits::filter_traits<profiled<p_sum>>::args_type,
+                     helpers::typelist<int, int>>,
+      "[-][profile_test] profiled traits failed");
+  static_assert(detail::latency_bucket(0) == 0 &&
+                    detail::latency_bucket(1) == 1 &&
+                    detail::latency_bucket(1000) == 10,
+                "[-][profile_test] latency bucket failed");
+
+  profiler::reset();
+
+  // same results as the plain pipe
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(profiled_t::process(i), plain_t::process(i));
+    EXPECT_EQ(profiled_t::reverse(plain_t::process(i)), i);
+  }
+
+  auto const add1 = stats_of<p_add1>("process");
+  EXPECT_EQ(add1.count, 100u);
+  EXPECT_LE(add1.min_ns, add1.max_ns);
+  EXPECT_GE(add1.total_ns, add1.max_ns);
+
+  std::uint64_t in_histogram = 0;
+  for (auto const h : add1.histogram) {
+    in_histogram += h;
+  }
+  EXPECT_EQ(in_histogram, 100u);
+
+  EXPECT_EQ(stats_of<p_twice>("process").count, 100u);
+  EXPECT_EQ(stats_of<p_twice>("reverse").count, 100u);
+  EXPECT_EQ(stats_of<p_add1>("reverse").count, 100u);
+
+  // calls of other threads are merged on demand, also once they exited
+  std::thread{[] {
+    for (int i = 0; i < 50; ++i) {
+      profiled_t::process(i);
+    }
+  }}.join();
+  EXPECT_EQ(stats_of<p_add1>("process").count, 150u);
+
+  // branches are timed as a whole, self is kept as is
+  using branch_t = pipet::pipe<p_square, p_add1>;
+  using branches_t = pipet::pipe<profile, p_add1,
+                                 branches<placeholders::self, branch_t>, p_sum>;
+  EXPECT_EQ(branches_t::process(2), 3 + 10);
+  EXPECT_EQ(stats_of<p_square>("process").count, 0u);
+  EXPECT_EQ(stats_of<p_sum>("process").count, 1u);
+  EXPECT_EQ(stats_of<branch_t>("process").count, 1u);
+
+  // own batch routines are timed per block
+  std::vector<int> in(10000, 1), out(in.size());
+  pipet::pipe<profile, p_batch, p_add1>::process_batch(in, out);
+  EXPECT_EQ(out[0], 5);
+  EXPECT_GE(stats_of<p_batch>("process_batch").count, 1u);
+  EXPECT_LT(stats_of<p_batch>("process_batch").count, in.size());
+  EXPECT_EQ(stats_of<p_add1>("process").count, 151u + in.size());
+
+  // report keyed by filter type name
+  std::ostringstream os;
+  profiler::dump(os);
+  EXPECT_NE(os.str().find("p_twice"), std::string::npos);
+  EXPECT_NE(os.str().find("reverse"), std::string::npos);
+
+  profiler::reset();
+  EXPECT_EQ(stats_of<p_add1>("process").count, 0u);
+}
+
+TEST(profile_test, optimize) {
+  // profiled pipes run the stages of the plain pipe
+  using plain_t = pipet::pipe<p_shift<1>, p_shift_slow, p_negate, p_negate,
+                              p_shift<2>, p_add1, pipet::inverse<p_add1>>;
+  using profiled_t =
+      pipet::pipe<profile, p_shift<1>, p_shift_slow, p_negate, p_negate,
+                  p_shift<2>, p_add1, pipet::inverse<p_add1>>;
+  static_assert(
+      std::is_same_v<plain_t::filters_type,
+                     helpers::typelist<p_shift<3>, p_shift_slow>>,
+      "[-][profile_test] plain pipe not optimized");
+  static_assert(
+      std::is_same_v<profiled_t::filters_type,
+                     helpers::typelist<profiled<p_shift<3>>,
+                                       profiled<p_shift_slow>>>,
+      "[-][profile_test] profiled pipe not optimized");
+
+  // constant evaluations are not timed
+  static_assert(profiled_t::process(1) == plain_t::process(1),
+                "[-][profile_test] constexpr process failed");
+  static_assert(profiled_t::reverse(5) == plain_t::reverse(5),
+                "[-][profile_test] constexpr reverse failed");
+
+  profiler::reset();
+  int in = 1;
+  EXPECT_EQ(profiled_t::process(in), 5);
+  EXPECT_EQ(stats_of<p_shift<3>>("process").count, 1u);
+  EXPECT_EQ(stats_of<p_negate>("process").count, 0u);
+  EXPECT_EQ(stats_of<p_add1>("process").count, 0u);
+}
+
+int profile_test(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_filter = "profile_test*";
+
+  return RUN_ALL_TESTS();
+}
\ No newline at end of file
@@ -16,6 +16,10 @@
 
 #include "gtest/gtest.h"
 
+#include <array>
+#include <random>
+#include <vector>
+
 using namespace pipet::extra;
 
 namespace {
@@ -23,6 +27,54 @@ namespace {
 constexpr uint64_t unsigned_lcg(uint64_t round) {
   return (round ? (unsigned_lcg(round - 1) * 16807) % 2147483647 : 1u);
 }
+
+// lcg with a modulus above 32 bits (2^61 - 1)
+using large_lcg = mul_lcg<uint64_t, 1u, 48271, (uint64_t{1} << 61) - 1>;
+
+// multipliers for which Schrage's method is not exact (M % A >= M / A)
+using wide_lcg = mul_lcg<uint32_t, 1u, 2147483629u, 2147483647u>;
+using wide_large_lcg = mul_lcg<uint64_t, 3u, (uint64_t{1} << 61) - 3,
+                               (uint64_t{1} << 61) - 1>;
+
+// the n-th call of next returns rand(n)
+template <typename Gen> void check_stream() {
+  Gen gen;
+  for (std::size_t i = 1; i <= 1000; ++i) {
+    EXPECT_EQ(gen.next(), Gen{}.rand(i));
+  }
+}
+
+// scalar reference of fill
+template <typename Gen, typename T>
+std::vector<T> next_n(Gen gen, std::size_t n) {
+  std::vector<T> res(n);
+  for (auto &v : res) {
+    v = gen.next();
+  }
+  return res;
+}
+
+template <typename Gen, typename T> void check_fill() {
+  for (std::size_t n : {0, 1, 7, 8, 9, 63, 64, 1000, 4099}) {
+    Gen gen;
+    gen.discard(n);
+    auto const expected = next_n<Gen, T>(gen, n);
+
+    std::vector<T> out(n);
+    gen.fill(out);
+    EXPECT_EQ(out, expected);
+
+    // the stream continues after the filled values
+    EXPECT_EQ(gen.next(), Gen{}.rand(2 * n + 1));
+  }
+}
+
+constexpr auto filled() {
+  std::array<uint32_t, 20> res{};
+  minstand_lcg<uint32_t> gen;
+  gen.fill(res);
+  return res;
+}
 } // namespace
 
 TEST(random_test, main) {
@@ -42,6 +94,180 @@ TEST(random_test, main) {
   EXPECT_EQ(gen.rand(256, 5, 128), 5 + unsigned_lcg(256) % (128 - 5));
 }
 
+TEST(random_test, jump_ahead) {
+  // reference value of minstd_rand0 (10000th value)
+  static_assert(minstand_lcg<uint32_t>{}.rand(10000) == 1043618065,
+                "[-][random_test] jump ahead failed");
+  static_assert(minstand_lcg<uint32_t>{}.rand(std::size_t{1} << 32) != 0,
+                "[-][random_test] jump ahead failed");
+
+  std::minstd_rand0 ref;
+  minstand_lcg<uint32_t> gen;
+  for (std::size_t i = 1; i <= 1000; ++i) {
+    auto const expected = ref();
+    EXPECT_EQ(gen.rand(i), expected);
+    EXPECT_EQ(gen.next(), expected);
+  }
+
+  check_stream<large_lcg>();
+  check_stream<wide_lcg>();
+  check_stream<wide_large_lcg>();
+  static_assert(wide_lcg{}.rand(1) == 2147483629u,
+                "[-][random_test] jump ahead failed");
+}
+
+TEST(random_test, stream) {
+  constexpr auto stream = [] {
+    minstand_lcg<uint32_t> gen;
+    gen.next();
+    gen.discard(100);
+    return gen.next();
+  }();
+  static_assert(stream == minstand_lcg<uint32_t>{}.rand(102),
+                "[-][random_test] stream failed");
+
+  minstand_lcg<uint32_t> gen;
+  EXPECT_EQ(gen.state(), 1u);
+  gen.discard(0);
+  EXPECT_EQ(gen.state(), 1u);
+  gen.discard(std::size_t{1} << 32);
+  EXPECT_EQ(gen.state(), gen.rand(std::size_t{1} << 32));
+  EXPECT_EQ(gen.next(), gen.rand((std::size_t{1} << 32) + 1));
+
+  auto const v = gen.next(5, 128);
+  EXPECT_GE(v, 5u);
+  EXPECT_LT(v, 128u);
+}
+
+TEST(random_test, fill) {
+  static_assert(filled()[0] == minstand_lcg<uint32_t>{}.rand(1),
+                "[-][random_test] fill failed");
+  static_assert(filled()[19] == minstand_lcg<uint32_t>{}.rand(20),
+                "[-][random_test] fill failed");
+
+  check_fill<minstand_lcg<uint32_t>, uint32_t>();
+  check_fill<minstand_lcg<uint64_t>, uint64_t>();
+  check_fill<mul_lcg<uint32_t, 7u, 69069, 4294967295u>, uint32_t>();
+  check_fill<large_lcg, uint64_t>();
+
+  // bounded values are the ones of next(low, high)
+  minstand_lcg<uint32_t> gen, ref;
+  std::vector<uint32_t> out(1001);
+  gen.fill(out, 3, 17);
+  for (auto const v : out) {
+    EXPECT_EQ(v, ref.next(3, 17));
+  }
+
+#if PIPET_X86_SIMD
+  // every kernel available on this cpu
+  constexpr auto ak = detail::pow_mod<2147483647>(16807, detail::lcg_lanes);
+  uint64_t lanes[detail::lcg_lanes];
+  for (std::size_t i = 0; i < detail::lcg_lanes; ++i) {
+    lanes[i] = minstand_lcg<uint32_t>{}.rand(i + 1);
+  }
+  auto const expected = next_n<minstand_lcg<uint32_t>, uint32_t>({}, 64);
+
+  std::vector<uint32_t> sse2(64);
+  detail::lcg_fill_sse2<uint32_t, 2147483647, ak>(lanes, sse2.data(), 8);
+  EXPECT_EQ(sse2, expected);
+
+  if (pipet::helpers::cpu().avx2) {
+    std::vector<uint32_t> avx2(64);
+    detail::lcg_fill_avx2<uint32_t, 2147483647, ak>(lanes, avx2.data(), 8);
+    EXPECT_EQ(avx2, expected);
+  }
+#endif
+}
+
+TEST(random_test, splitmix64) {
+  static_assert(splitmix64{}.rand(1) == 0xe220a8397b1dcdaf,
+                "[-][random_test] splitmix64 failed");
+  static_assert(splitmix64{1234567}.rand(3) == 9817491932198370423u,
+                "[-][random_test] splitmix64 failed");
+
+  splitmix64 gen{1234567};
+  EXPECT_EQ(gen.next(), 6457827717110365317u);
+  EXPECT_EQ(gen.next(), 3203168211198807973u);
+  gen.discard(10);
+  EXPECT_EQ(gen.next(), gen.rand(13));
+
+  auto child = gen.split();
+  EXPECT_NE(child.next(), gen.next());
+}
+
+TEST(random_test, xoshiro256ss) {
+  static_assert(xoshiro256ss{std::array<uint64_t, 4>{1, 2, 3, 4}}() == 11520,
+                "[-][random_test] xoshiro256ss failed");
+  static_assert(xoshiro256ss{}() == 11091344671253066420u,
+                "[-][random_test] xoshiro256ss failed");
+
+  xoshiro256ss gen{std::array<uint64_t, 4>{1, 2, 3, 4}};
+  EXPECT_EQ(gen.next(), 11520u);
+  EXPECT_EQ(gen.next(), 0u);
+  EXPECT_EQ(gen.next(), 1509978240u);
+
+  // reference state after a jump (checked against the 2^128 power of the
+  // transition matrix)
+  xoshiro256ss jumped{std::array<uint64_t, 4>{1, 2, 3, 4}};
+  jumped.jump();
+  EXPECT_EQ(jumped.state(),
+            (std::array<uint64_t, 4>{0x8c7a153956b5f3d1, 0x701f1a713401d85e,
+                                     0x6527f66a65469085, 0x8386b786c4408050}));
+
+  // jumps commute with the stream
+  xoshiro256ss a{42}, b{42};
+  a.next();
+  a.long_jump();
+  b.long_jump();
+  b.next();
+  EXPECT_EQ(a.state(), b.state());
+
+  auto const s2 = xoshiro256ss{42}.stream(2);
+  xoshiro256ss c{42};
+  c.jump();
+  c.jump();
+  EXPECT_EQ(c.state(), s2.state());
+}
+
+TEST(random_test, pcg32) {
+  // pcg32 reference output (seed 42, stream 54)
+  static_assert(pcg32{42, 54}.rand(1) == 0xa15c02b7,
+                "[-][random_test] pcg32 failed");
+  static_assert(pcg32{42, 54}.rand(6) == 0xcbed606e,
+                "[-][random_test] pcg32 failed");
+
+  pcg32 gen{42, 54};
+  for (auto const v : {0xa15c02b7u, 0x7b47f409u, 0xba1d3330u, 0x83d2f293u,
+                       0xbfa4784bu, 0xcbed606eu}) {
+    EXPECT_EQ(gen.next(), v);
+  }
+
+  gen.discard(1000);
+  EXPECT_EQ(gen.next(), gen.rand(1007));
+  EXPECT_NE(pcg32(42, 1).next(), pcg32(42, 2).next());
+}
+
+TEST(random_test, engines) {
+  // bounded values and fill share the stream
+  pcg32 gen, ref;
+  std::vector<uint32_t> out(100);
+  gen.fill(out, 10, 20);
+  for (auto const v : out) {
+    EXPECT_GE(v, 10u);
+    EXPECT_LT(v, 20u);
+    EXPECT_EQ(v, ref.next(10, 20));
+  }
+
+  xoshiro256ss x;
+  std::uniform_int_distribution<int> dist{1, 6};
+  auto const roll = dist(x);
+  EXPECT_GE(roll, 1);
+  EXPECT_LE(roll, 6);
+
+  EXPECT_EQ(detail::mul_hi(~uint64_t{0}, ~uint64_t{0}), ~uint64_t{0} - 1);
+  EXPECT_EQ(detail::scale<uint64_t>(~uint64_t{0}, 1000), 999u);
+}
+
 int random_test(int argc, char *argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
   ::testing::FLAGS_gtest_filter = "random_test*";
@@ -16,6 +16,8 @@
 
 #include "gtest/gtest.h"
 
+#include <utility>
+
 using namespace pipet::helpers;
 
 //-------------------------------------
@@ -33,6 +35,9 @@ struct bar {
 int f(int, double);
 void g();
 
+// function type only (no declaration left undefined)
+using h_t = int(int const &, double &&);
+
 template <typename T, typename Ret, typename... Args>
 using has_test_t = std::integral_constant<Ret (T::*)(Args...), &T::test>;
 
@@ -74,9 +79,17 @@ TEST(reflect_test, main) {
       "[-][reflect_test] function_args failed");
   static_assert(std::is_same_v<typelist<>, decltype(function_args(g))>,
                 "[-][reflect_test] function_args failed");
+  static_assert(std::is_same_v<typelist<int, double>,
+                               decltype(function_args(std::declval<h_t *>()))>,
+                "[-][reflect_test] function_args failed");
+  static_assert(
+      std::is_same_v<typelist<int const &, double &&>,
+                     decltype(function_params(std::declval<h_t *>()))>,
+      "[-][reflect_test] function_params failed");
 
-  // no dynamic test
-  EXPECT_TRUE(true);
+  // type name
+  static_assert(type_name<int>() == "int", "[-][reflect_test] type_name failed");
+  EXPECT_NE(type_name<foo>().find("foo"), std::string_view::npos);
 }
 
 int reflect_test(int argc, char *argv[]) {
@@ -0,0 +1,133 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pipet/pipet.h"
+#include "pipet/repeat.h"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+using namespace pipet;
+
+namespace {
+struct f_mul3 {
+  static constexpr uint32_t process(uint32_t a) { return a * 3; }
+
+  // 3 is odd, inverse mod 2^32
+  static constexpr uint32_t reverse(uint32_t a) { return a * 0xaaaaaaabu; }
+};
+
+// round aware filter, runtime or compile-time index
+struct f_add_round {
+  static constexpr uint32_t process(uint32_t a, std::size_t round) {
+    return a + static_cast<uint32_t>(round + 1) * 10;
+  }
+
+  static constexpr uint32_t reverse(uint32_t a, std::size_t round) {
+    return a - static_cast<uint32_t>(round + 1) * 10;
+  }
+};
+
+// round aware filter only usable fully unrolled
+constexpr std::array<uint32_t, 4> round_keys = {0x11, 0x22, 0x44, 0x88};
+
+struct f_xor_key {
+  template <std::size_t I>
+  static constexpr uint32_t process(uint32_t a, round_index<I>) {
+    return a ^ std::get<I>(round_keys);
+  }
+
+  template <std::size_t I>
+  static constexpr uint32_t reverse(uint32_t a, round_index<I>) {
+    return a ^ std::get<I>(round_keys);
+  }
+};
+
+struct f_inc {
+  static constexpr uint32_t process(uint32_t a) { return a + 1; }
+};
+
+using round_t = round_pipe<f_mul3, f_add_round>;
+
+// reference loop
+constexpr uint32_t rounds(uint32_t v, std::size_t n) {
+  for (std::size_t r = 0; r < n; ++r) {
+    v = v * 3 + static_cast<uint32_t>(r + 1) * 10;
+  }
+  return v;
+}
+} // namespace
+
+TEST(repeat_test, unroll) {
+  // full unroll, partial unroll with remainder, rolled loop
+  static_assert(repeat<round_t, 7>::process(5) == rounds(5, 7),
+                "[-][repeat_test] fully unrolled repeat failed");
+  static_assert(repeat<round_t, 7, 3>::process(5) == rounds(5, 7),
+                "[-][repeat_test] partially unrolled repeat failed");
+  static_assert(repeat<round_t, 7, 1>::process(5) == rounds(5, 7),
+                "[-][repeat_test] rolled repeat failed");
+  static_assert(repeat<round_t, 0>::process(5) == 5,
+                "[-][repeat_test] empty repeat failed");
+
+  for (uint32_t v : {0u, 1u, 42u, 0xdeadbeefu}) {
+    EXPECT_EQ((repeat<round_t, 8, 4>::process(v)), rounds(v, 8));
+    EXPECT_EQ((repeat<round_t, 8, 3>::process(v)), rounds(v, 8));
+    EXPECT_EQ((repeat<round_t, 8, 1>::process(v)), rounds(v, 8));
+  }
+}
+
+TEST(repeat_test, reverse) {
+  static_assert(repeat<round_t, 7>::reverse(rounds(5, 7)) == 5,
+                "[-][repeat_test] fully unrolled reverse failed");
+
+  for (uint32_t v : {0u, 1u, 42u, 0xdeadbeefu}) {
+    EXPECT_EQ((repeat<round_t, 8, 3>::reverse(rounds(v, 8))), v);
+    EXPECT_EQ((repeat<round_t, 8, 1>::reverse(rounds(v, 8))), v);
+  }
+
+  // non reversible round, no reverse (plain filters, pipe as round)
+  using p_t = pipet::pipe<f_inc>;
+  static_assert(
+      std::is_same_v<traits::filter_traits<repeat<p_t, 3>>::filter_type,
+                     filter_proc>,
+      "[-][repeat_test] non reversible repeat");
+  static_assert(repeat<p_t, 3>::process(1) == 4,
+                "[-][repeat_test] non reversible repeat failed");
+}
+
+TEST(repeat_test, compile_time_index) {
+  using p_t = round_pipe<f_inc, f_xor_key>;
+  using r_t = repeat<p_t, 4>;
+
+  // rounds: 0x01 ^ 0x11, 0x11 ^ 0x22, 0x34 ^ 0x44, 0x71 ^ 0x88
+  static_assert(r_t::process(0) == 0xf9,
+                "[-][repeat_test] compile-time round index failed");
+}
+
+TEST(repeat_test, in_pipe) {
+  using p_t = pipet::pipe<f_mul3, repeat<round_t, 5, 2>, f_mul3>;
+
+  EXPECT_EQ(p_t::process(3), rounds(9, 5) * 3);
+  EXPECT_EQ(p_t::reverse(p_t::process(3)), 3u);
+}
+
+int repeat_test(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_filter = "repeat_test*";
+
+  return RUN_ALL_TESTS();
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pipet/extra/bit.h"
+#include "pipet/extra/sample.h"
+#include "pipet/pipet.h"
+
+#include "gtest/gtest.h"
+
+#include <set>
+#include <vector>
+
+using namespace pipet::extra;
+
+//-------------------------------------
+// Utility
+
+namespace {
+template <typename Array> constexpr bool all_distinct(Array const &a) {
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    for (std::size_t j = i + 1; j < a.size(); ++j) {
+      if (a[i] == a[j]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <typename Array>
+constexpr bool all_below(Array const &a, std::size_t n) {
+  for (auto const i : a) {
+    if (i >= n) {
+      return false;
+    }
+  }
+  return true;
+}
+
+struct mask_count_filter {
+  static constexpr auto process(uint64_t mask) { return bit_count(mask); }
+};
+} // namespace
+
+//-------------------------------------
+// Static Tests
+
+// full population, small population (bitset) and large population (scan)
+static_assert(all_distinct(sample_unique<64, 64>::process(1)),
+              "[-][sample_test] sample_unique failed");
+static_assert(all_distinct(sample_unique<16, 100>::process(7)) &&
+                  all_below(sample_unique<16, 100>::process(7), 100),
+              "[-][sample_test] sample_unique failed");
+static_assert(all_distinct(sample_unique<32, 1000000>::process(3)) &&
+                  all_below(sample_unique<32, 1000000>::process(3), 1000000),
+              "[-][sample_test] sample_unique failed");
+static_assert(sample_unique<0, 10>::process(3).size() == 0,
+              "[-][sample_test] sample_unique failed");
+
+static_assert(bit_count(sample_unique_mask<4>::process(0)) == 4,
+              "[-][sample_test] sample_unique_mask failed");
+static_assert(bit_count(sample_unique_mask<64>::process(0)) == 64,
+              "[-][sample_test] sample_unique_mask failed");
+static_assert(bit_count(sample_unique_mask<5, uint8_t>::process(9)) == 5,
+              "[-][sample_test] sample_unique_mask failed");
+
+static_assert(pipet::pipe<sample_unique_mask<12>, mask_count_filter>::process(
+                  42) == 12,
+              "[-][sample_test] sample_unique_mask pipe failed");
+
+//-------------------------------------
+// Dynamic Tests
+
+TEST(sample_test, main) {
+  // every seed gives exactly K distinct bits, different seeds differ
+  std::set<uint64_t> masks;
+  for (uint64_t seed = 0; seed < 1000; ++seed) {
+    auto const m = sample_unique_mask<8>::process(seed);
+    EXPECT_EQ(bit_count(m), 8u);
+    masks.insert(m);
+  }
+  EXPECT_GT(masks.size(), 990u);
+
+  // each index is drawn with the same probability (loose bound)
+  std::vector<std::size_t> hits(16);
+  pcg32 gen{5};
+  for (int i = 0; i < 16000; ++i) {
+    for (auto const idx : sample_unique<4, 16>::draw(gen)) {
+      ++hits[idx];
+    }
+  }
+  for (auto const h : hits) {
+    EXPECT_GT(h, 3600u);
+    EXPECT_LT(h, 4400u);
+  }
+}
+
+TEST(sample_test, batch) {
+  using sampler_t = sample_unique<10, 5000, xoshiro256ss>;
+
+  std::vector<uint64_t> seeds(100);
+  for (std::size_t i = 0; i < seeds.size(); ++i) {
+    seeds[i] = i * 31;
+  }
+
+  std::vector<sampler_t::index_array> out(seeds.size());
+  sampler_t::process_batch(seeds, out);
+  for (std::size_t i = 0; i < seeds.size(); ++i) {
+    EXPECT_EQ(out[i], sampler_t::process(seeds[i]));
+    EXPECT_TRUE(all_distinct(out[i]));
+  }
+
+  // samples of one stream
+  xoshiro256ss gen{11}, ref{11};
+  sampler_t::fill(gen, out);
+  for (auto const &s : out) {
+    EXPECT_EQ(s, sampler_t::draw(ref));
+  }
+
+  // through a pipe
+  std::vector<uint64_t> masks(seeds.size());
+  pipet::pipe<sample_unique_mask<20>>::process_batch(seeds, masks);
+  for (std::size_t i = 0; i < seeds.size(); ++i) {
+    EXPECT_EQ(masks[i], sample_unique_mask<20>::process(seeds[i]));
+  }
+}
+
+int sample_test(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_filter = "sample_test*";
+
+  return RUN_ALL_TESTS();
+}
\ No newline at end of file
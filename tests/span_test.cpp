@@ -0,0 +1,61 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pipet/helpers/span.h"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <vector>
+
+using namespace pipet::helpers;
+
+namespace {
+constexpr auto sum(span<int const> s) {
+  int res = 0;
+  for (auto v : s) {
+    res += v;
+  }
+  return res;
+}
+
+constexpr std::array<int, 4> arr{1, 2, 3, 4};
+} // namespace
+
+TEST(span_test, main) {
+  // test compile-time view
+  static_assert(sum(arr) == 10, "[-][span_test] span failed");
+  static_assert(span<int const>(arr).size() == 4, "[-][span_test] span failed");
+  static_assert(sum(span<int const>(arr).subspan(1, 2)) == 5,
+                "[-][span_test] subspan failed");
+  static_assert(span<int const>{}.empty(), "[-][span_test] empty failed");
+
+  // runtime tests
+  std::vector<int> v{1, 2, 3};
+  span<int> s{v};
+  s[0] = 5;
+  EXPECT_EQ(v[0], 5);
+  EXPECT_EQ(s.data(), v.data());
+  EXPECT_EQ(sum(s), 10);
+
+  int c_arr[2] = {7, 8};
+  EXPECT_EQ(sum(c_arr), 15);
+}
+
+int span_test(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_filter = "span_test*";
+
+  return RUN_ALL_TESTS();
+}
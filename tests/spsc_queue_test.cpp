@@ -0,0 +1,83 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pipet/helpers/spsc_queue.h"
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <thread>
+
+using namespace pipet::helpers;
+
+TEST(spsc_queue_test, main) {
+  // test bounded behavior
+  spsc_queue<int, 4> q;
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.try_pop());
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(q.try_push(i));
+  }
+  EXPECT_FALSE(q.try_push(4));
+
+  EXPECT_EQ(q.try_pop(), 0);
+  EXPECT_TRUE(q.try_push(4));
+  for (int i = 1; i < 5; ++i) {
+    EXPECT_EQ(q.try_pop(), i);
+  }
+  EXPECT_TRUE(q.empty());
+
+  // test move only type and pending items release
+  auto owned = std::make_shared<int>(1);
+  {
+    spsc_queue<std::shared_ptr<int>, 2> sq;
+    EXPECT_TRUE(sq.try_push(owned));
+    EXPECT_EQ(owned.use_count(), 2);
+  }
+  EXPECT_EQ(owned.use_count(), 1);
+
+  spsc_queue<std::unique_ptr<int>, 2> uq;
+  EXPECT_TRUE(uq.try_emplace(std::make_unique<int>(3)));
+  EXPECT_EQ(**uq.try_pop(), 3);
+
+  // test concurrent producer/consumer ordering
+  constexpr int count = 100000;
+  spsc_queue<int, 64> cq;
+  std::thread producer{[&cq] {
+    for (int i = 0; i < count; ++i) {
+      while (!cq.try_push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  }};
+
+  int expected = 0;
+  while (expected < count) {
+    if (auto v = cq.try_pop()) {
+      EXPECT_EQ(*v, expected);
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+}
+
+int spsc_queue_test(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_filter = "spsc_queue_test*";
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,155 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pipet/stream.h"
+#include "test_common.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace pipet;
+using namespace pipet::test;
+
+namespace {
+struct f_throw_rt {
+  static int process(int a) {
+    if (a == 42) {
+      throw std::invalid_argument("bad input");
+    }
+    return a;
+  }
+};
+
+struct f_negate {
+  using inverse_type = f_negate;
+
+  static constexpr int process(int a) { return -a; }
+};
+} // namespace
+
+TEST(stream_test, main) {
+  // test stage building
+  using branch1_t = pipet::pipe<f1_proc_ct, f_square_ct>;
+  using pipe_t =
+      pipet::pipe<f1_proc_ct,
+                  pipet::branches<pipet::placeholders::self, branch1_t,
+                                  f_cube_ct>,
+                  f_add3_ct, pipet::pipe<f1_proc_ct, f_square_ct>>;
+  static_assert(
+      std::is_same_v<detail::stream_stages_t<pipe_t>,
+                     helpers::typelist<f1_proc_ct,
+                                       pipet::pipe<pipet::branches<
+                                                       pipet::placeholders::self,
+                                                       branch1_t, f_cube_ct>,
+                                                   f_add3_ct>,
+                                       pipet::pipe<f1_proc_ct, f_square_ct>>>,
+      "[-][stream_test] stage building failed");
+
+  // test streaming with backpressure (small queues)
+  constexpr int count = 20000;
+  {
+    stream_runner<pipe_t, 8> runner;
+    EXPECT_EQ(runner.stages(), 3u);
+
+    std::thread producer{[&runner] {
+      for (int i = 0; i < count; ++i) {
+        runner.push(i % 10);
+      }
+      runner.close();
+    }};
+
+    int received = 0;
+    while (auto v = runner.pop()) {
+      EXPECT_EQ(*v, pipe_t::process(received % 10));
+      ++received;
+    }
+    producer.join();
+    EXPECT_EQ(received, count);
+  }
+
+  // test stages of the optimized pipe (cancelled pair not streamed)
+  {
+    using opt_pipe_t =
+        pipet::pipe<f1_proc_ct, f_negate, f_negate, f_negate, f_square_ct>;
+    stream_runner<opt_pipe_t> runner;
+    EXPECT_EQ(runner.stages(), 3u);
+    runner.push(3);
+    runner.close();
+    EXPECT_EQ(runner.pop(), opt_pipe_t::process(3));
+    EXPECT_FALSE(runner.pop());
+  }
+
+  // test idle stages (asleep after their spin) woken by a slow producer
+  {
+    stream_runner<pipet::pipe<f1_proc_ct, f_square_ct>, 2> runner;
+
+    std::thread producer{[&runner] {
+      for (int i = 0; i < 4; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        runner.push(i);
+      }
+      runner.close();
+    }};
+
+    int received = 0;
+    while (auto v = runner.pop()) {
+      EXPECT_EQ(*v, received * received);
+      ++received;
+    }
+    producer.join();
+    EXPECT_EQ(received, 4);
+  }
+
+  // test move only data
+  {
+    stream_runner<pipet::pipe<f1_proc_rt, f1_proc_ct>> runner;
+    runner.push(std::make_unique<int>(7));
+    runner.close();
+    EXPECT_EQ(runner.pop(), 7);
+    EXPECT_FALSE(runner.pop());
+  }
+
+  // test failure propagation
+  {
+    stream_runner<pipet::pipe<f1_proc_ct, f_throw_rt>> runner;
+    runner.push(1);
+    runner.push(42);
+    runner.close();
+    EXPECT_THROW(
+        {
+          while (runner.pop()) {
+          }
+        },
+        std::invalid_argument);
+  }
+
+  // test early destruction with pending items
+  {
+    stream_runner<pipet::pipe<f1_proc_ct, f_square_ct>, 4> runner;
+    for (int i = 0; i < 4; ++i) {
+      runner.push(i);
+    }
+  }
+}
+
+int stream_test(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_filter = "stream_test*";
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,195 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pipet/pipet.h"
+#include "pipet/tabulate.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <vector>
+
+using namespace pipet;
+
+namespace {
+struct f_add {
+  static constexpr uint8_t process(uint8_t a) {
+    return static_cast<uint8_t>(a + 0x5a);
+  }
+
+  static constexpr uint8_t reverse(uint8_t a) {
+    return static_cast<uint8_t>(a - 0x5a);
+  }
+};
+
+struct f_rot {
+  static constexpr uint8_t process(uint8_t a) {
+    return static_cast<uint8_t>((a << 3) | (a >> 5));
+  }
+
+  static constexpr uint8_t reverse(uint8_t a) {
+    return static_cast<uint8_t>((a >> 3) | (a << 5));
+  }
+};
+
+struct f_mul16 {
+  static constexpr uint16_t process(uint16_t a) {
+    return static_cast<uint16_t>(a * 0x9e37u);
+  }
+
+  // odd multiplier, inverse mod 2^16
+  static constexpr uint16_t reverse(uint16_t a) {
+    return static_cast<uint16_t>(a * 0x7787u);
+  }
+};
+
+struct f_square {
+  static constexpr int16_t process(int8_t a) { return a * a; }
+};
+
+struct f_widen {
+  static constexpr uint32_t process(uint8_t a) { return a * 1000u; }
+
+  static constexpr uint8_t reverse(uint32_t a) {
+    return static_cast<uint8_t>(a / 1000u);
+  }
+};
+
+// injective, not surjective
+struct f_triple {
+  static constexpr uint16_t process(uint8_t a) {
+    return static_cast<uint16_t>(a * 3u);
+  }
+
+  static constexpr uint8_t reverse(uint16_t a) {
+    return static_cast<uint8_t>(a / 3u);
+  }
+};
+
+struct f_dec {
+  static constexpr uint32_t process(uint32_t a) { return a - 1; }
+};
+
+using p_byte = pipet::pipe<f_add, f_rot, f_add>;
+} // namespace
+
+TEST(tabulate_test, process) {
+  using t = tabulate<p_byte>;
+
+  for (unsigned i = 0; i < 256; ++i) {
+    auto const v = static_cast<uint8_t>(i);
+    EXPECT_EQ(t::process(v), p_byte::process(v));
+  }
+
+  static_assert(t::process(0) == p_byte::process(0));
+  static_assert(sizeof(t::table) == 256);
+}
+
+TEST(tabulate_test, reverse) {
+  using t = tabulate<p_byte>;
+
+  for (unsigned i = 0; i < 256; ++i) {
+    auto const v = static_cast<uint8_t>(i);
+    EXPECT_EQ(t::reverse(v), p_byte::reverse(v));
+    EXPECT_EQ(t::reverse(t::process(v)), v);
+  }
+
+  static_assert(t::reverse(t::process(17)) == 17);
+}
+
+TEST(tabulate_test, domain_16bit) {
+  using t = tabulate<f_mul16>;
+
+  for (unsigned i = 0; i < 65536; i += 251) {
+    auto const v = static_cast<uint16_t>(i);
+    EXPECT_EQ(t::process(v), f_mul16::process(v));
+    EXPECT_EQ(t::reverse(t::process(v)), v);
+  }
+
+  static_assert(detail::tabulate_io<f_mul16>::table_bytes == 2 * 65536 * 2);
+}
+
+TEST(tabulate_test, signed_domain) {
+  using t = tabulate<f_square>;
+
+  for (int i = -128; i < 128; ++i) {
+    auto const v = static_cast<int8_t>(i);
+    EXPECT_EQ(t::process(v), i * i);
+  }
+}
+
+TEST(tabulate_test, large_codomain) {
+  // output too large for an inverse table, reverse is the filter one
+  using t = tabulate<f_widen>;
+
+  static_assert(!detail::tabulate_io<f_widen>::has_inverse_table);
+  static_assert(detail::tabulate_io<f_widen>::table_bytes == 256 * 4);
+
+  for (unsigned i = 0; i < 256; ++i) {
+    auto const v = static_cast<uint8_t>(i);
+    EXPECT_EQ(t::process(v), i * 1000u);
+    EXPECT_EQ(t::reverse(t::process(v)), v);
+  }
+}
+
+TEST(tabulate_test, partial_image) {
+  // values out of the image are reversed by the filter
+  using t = tabulate<f_triple>;
+
+  static_assert(!t::inverse.is_surjective);
+  static_assert(tabulate<f_mul16>::in_image.empty());
+
+  for (unsigned i = 0; i < 1024; ++i) {
+    auto const v = static_cast<uint16_t>(i);
+    EXPECT_EQ(t::reverse(v), f_triple::reverse(v));
+  }
+  static_assert(t::reverse(7) == 2 && t::reverse(9) == 3);
+
+  std::vector<uint16_t> in{7, 9, 600};
+  std::vector<uint8_t> out(in.size());
+  t::reverse_batch(in, out);
+  EXPECT_EQ(out, (std::vector<uint8_t>{2, 3, 200}));
+}
+
+TEST(tabulate_test, batch) {
+  using t = tabulate<p_byte>;
+
+  std::vector<uint8_t> in(300), out(300), back(300);
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    in[i] = static_cast<uint8_t>(i * 7);
+  }
+
+  t::process_batch(in, out);
+  t::reverse_batch(out, back);
+
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    EXPECT_EQ(out[i], p_byte::process(in[i]));
+    EXPECT_EQ(back[i], in[i]);
+  }
+}
+
+TEST(tabulate_test, in_pipe) {
+  // tabulated stage composed with regular filters
+  using p = pipet::pipe<tabulate<f_widen>, f_dec>;
+
+  EXPECT_EQ(p::process(3), 2999u);
+  EXPECT_EQ(p::process(0), 0xffffffffu);
+}
+
+int tabulate_test(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_filter = "tabulate_test*";
+
+  return RUN_ALL_TESTS();
+}
\ No newline at end of file
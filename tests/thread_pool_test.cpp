@@ -0,0 +1,72 @@
+// Copyright 2018 Ken Avolic <kenavolic@none.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pipet/helpers/thread_pool.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <stdexcept>
+
+using namespace pipet::helpers;
+
+TEST(thread_pool_test, main) {
+  thread_pool pool{2};
+  EXPECT_EQ(pool.size(), 2u);
+
+  // test task joining
+  std::atomic<int> counter{0};
+  {
+    task_group group{pool};
+    for (int i = 0; i < 100; ++i) {
+      group.run([&counter] { ++counter; });
+    }
+    group.wait();
+    EXPECT_EQ(counter, 100);
+  }
+
+  // test nested groups on a single worker (waiting thread must help)
+  thread_pool single{1};
+  counter = 0;
+  {
+    task_group outer{single};
+    for (int i = 0; i < 4; ++i) {
+      outer.run([&single, &counter] {
+        task_group inner{single};
+        for (int j = 0; j < 4; ++j) {
+          inner.run([&counter] { ++counter; });
+        }
+        inner.wait();
+      });
+    }
+    outer.wait();
+  }
+  EXPECT_EQ(counter, 16);
+
+  // test failure propagation
+  task_group failing{pool};
+  failing.run([] { throw std::runtime_error("task failure"); });
+  failing.run([] {});
+  EXPECT_THROW(failing.wait(), std::runtime_error);
+
+  // test shared pool
+  EXPECT_GE(thread_pool::shared().size(), 1u);
+}
+
+int thread_pool_test(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  ::testing::FLAGS_gtest_filter = "thread_pool_test*";
+
+  return RUN_ALL_TESTS();
+}
@@ -21,6 +21,36 @@
 
 using namespace pipet::helpers;
 
+//-------------------------------------
+// Utility
+
+namespace {
+template <typename T> struct size_of {
+  static constexpr std::size_t value = sizeof(T);
+};
+
+// long lists (more items than a fold chunk)
+template <std::size_t I> struct item {};
+
+template <typename T> struct is_even_item : std::false_type {};
+
+template <std::size_t I>
+struct is_even_item<item<I>> : std::bool_constant<I % 2 == 0> {};
+
+template <std::size_t M, std::size_t... Is>
+typelist<item<Is % M>...> make_items(std::index_sequence<Is...>);
+
+template <std::size_t N, std::size_t M = N>
+using items_t = decltype(make_items<M>(std::make_index_sequence<N>{}));
+
+template <std::size_t... Is>
+typelist<item<2 * Is>...> make_even_items(std::index_sequence<Is...>);
+
+template <std::size_t N>
+using even_items_t =
+    decltype(make_even_items(std::make_index_sequence<N / 2>{}));
+} // namespace
+
 //-------------------------------------
 // Dynamic Tests
 
@@ -43,6 +73,12 @@ TEST(typelist_test, main) {
   static_assert(std::is_same_v<int, front_t<std::tuple<int>>>,
                 "[-][typelist_testtest] front failed");
 
+  // at
+  static_assert(std::is_same_v<int, at_t<0, typelist<int, double>>>,
+                "[-][typelist_test] at failed");
+  static_assert(std::is_same_v<double, at_t<1, std::tuple<int, double>>>,
+                "[-][typelist_test] at failed");
+
   // pop front
   static_assert(
       std::is_same_v<pop_front_t<typelist<int, double>>, typelist<double>>,
@@ -78,6 +114,10 @@ TEST(typelist_test, main) {
                 "[-][typelist_test] has failed");
   static_assert(!has_v<int, typelist<float, double>>,
                 "[-][typelist_test] has failed");
+  static_assert(has_v<item<299>, items_t<300>>,
+                "[-][typelist_test] has failed");
+  static_assert(!has_v<item<300>, items_t<300>>,
+                "[-][typelist_test] has failed");
 
   // remove dup
   static_assert(std::is_same_v<remove_dup_t<typelist<int, int>>, typelist<int>>,
@@ -110,6 +150,52 @@ TEST(typelist_test, main) {
           merge_all_t<typelist<int>, typelist<int, double>, typelist<double>>>,
       "[-][typelist] merge_all failed");
 
+  // remove dup (last occurrence kept)
+  static_assert(std::is_same_v<remove_dup_t<typelist<int, double, int, char>>,
+                               typelist<double, int, char>>,
+                "[-][typelist_test] remove_dup failed");
+  static_assert(std::is_same_v<remove_dup_t<typelist<>>, typelist<>>,
+                "[-][typelist_test] remove_dup failed");
+  static_assert(std::is_same_v<remove_dup_t<items_t<300>>, items_t<300>>,
+                "[-][typelist_test] remove_dup failed");
+  static_assert(std::is_same_v<remove_dup_t<items_t<300, 50>>, items_t<50>>,
+                "[-][typelist_test] remove_dup failed");
+
+  // index of
+  static_assert(0 == index_of_v<int, typelist<int, double, int>>,
+                "[-][typelist_test] index_of failed");
+  static_assert(1 == index_of_v<double, std::tuple<int, double, int>>,
+                "[-][typelist_test] index_of failed");
+
+  // transform
+  static_assert(std::is_same_v<transform_t<std::add_pointer, typelist<int, char>>,
+                               typelist<int *, char *>>,
+                "[-][typelist_test] transform failed");
+  static_assert(std::is_same_v<transform_t<std::add_pointer, typelist<>>,
+                               typelist<>>,
+                "[-][typelist_test] transform failed");
+
+  // filter
+  static_assert(
+      std::is_same_v<filter_t<std::is_integral, typelist<int, float, char>>,
+                     typelist<int, char>>,
+      "[-][typelist_test] filter failed");
+  static_assert(std::is_same_v<filter_t<std::is_integral, typelist<float>>,
+                               typelist<>>,
+                "[-][typelist_test] filter failed");
+  static_assert(std::is_same_v<filter_t<is_even_item, items_t<300>>,
+                               even_items_t<300>>,
+                "[-][typelist_test] filter failed");
+
+  // sort (stable)
+  static_assert(
+      std::is_same_v<
+          sort_t<size_of, typelist<double, char, int, unsigned char, float>>,
+          typelist<char, unsigned char, int, float, double>>,
+      "[-][typelist_test] sort failed");
+  static_assert(std::is_same_v<sort_t<size_of, typelist<>>, typelist<>>,
+                "[-][typelist_test] sort failed");
+
   // rebind
   static_assert(std::is_same_v<rebind_t<std::tuple, typelist<int, int>>,
                                std::tuple<int, int>>,